@@ -0,0 +1,63 @@
+// File: compile_btagscore_tables.cpp
+/*
+    Compile the b and non-b histogram files of PseudoBTagScore into one small binary
+    file of cumulative distribution tables, with the PT and |eta| bin edges embedded.
+    The histogram files and the bins are taken from the PseudoBTagScore module of the card.
+
+    The module then maps the file in memory instead of reading the histograms, with
+        set Jet_btagDeepFlavB_table "btagscore_histograms/JetBtagDeepFlavB_Tables.bin"
+    PTBins and AbsEtaBins can be removed from the card, if kept they must match the file.
+
+    The tables are stored in the native byte order, and must be compiled again
+    when the histograms or the bins change.
+
+    Run from the Delphes directory by
+    `root -l -q 'belphes-examples/scripts/compile_btagscore_tables.cpp("cards/belphes_card_CMS.tcl", "btagscore_histograms/JetBtagDeepFlavB_Tables.bin")'`.
+*/
+#ifdef __CLING__
+R__LOAD_LIBRARY(libDelphes)
+#include "classes/DelphesBTagScoreSampler.h"
+#include "external/ExRootAnalysis/ExRootConfReader.h"
+#endif
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void compile_btagscore_tables(
+    const std::string& card_dir   = "cards/belphes_card_CMS.tcl",
+    const std::string& output_dir = "btagscore_histograms/JetBtagDeepFlavB_Tables.bin",
+    const std::string& module     = "PseudoBTagScore")
+{
+    // 1) Read the module parameters from the card
+    ExRootConfReader conf;
+    conf.ReadFile(card_dir.c_str());
+
+    std::vector<Double_t> ptBins, absEtaBins;
+
+    ExRootConfParam paramPT = conf.GetParam((module + "::PTBins").c_str());
+    for (int i = 0; i < paramPT.GetSize(); ++i)
+        ptBins.push_back(paramPT[i].GetDouble());
+
+    ExRootConfParam paramAbsEta = conf.GetParam((module + "::AbsEtaBins").c_str());
+    for (int i = 0; i < paramAbsEta.GetSize(); ++i)
+        absEtaBins.push_back(paramAbsEta[i].GetDouble());
+
+    std::string file_b    = conf.GetString((module + "::Jet_btagDeepFlavB_file_b").c_str(),    "");
+    std::string file_nonb = conf.GetString((module + "::Jet_btagDeepFlavB_file_nonb").c_str(), "");
+
+    // 2) Build the tables from the histograms hist_eta[X]_pt[Y] and write them
+    try {
+        DelphesBTagScoreSampler sampler;
+        sampler.SetBins(ptBins, absEtaBins);
+        sampler.ReadHistograms(file_b.c_str(), file_nonb.c_str());
+        sampler.WriteTables(output_dir.c_str());
+    } catch (std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return;
+    }
+
+    std::cout << "Wrote " << 2 * (ptBins.size() - 1) * (absEtaBins.size() - 1)
+              << " tables to " << output_dir << std::endl;
+}
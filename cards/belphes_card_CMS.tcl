@@ -52,6 +52,9 @@ set ExecutionPath {
 
   PseudoBTagScore
 
+  # optional: stop here and skip the output of events failing a selection
+  # EventFilter
+
   UniqueObjectFinder
 
   ScalarHT
@@ -59,6 +62,52 @@ set ExecutionPath {
   TreeWriter
 }
 
+#######################################
+# Output file settings (optional)
+#######################################
+
+# set CompressionAlgorithm ZSTD
+# set CompressionLevel 5
+# set BasketSize 64000
+# set BasketSizes {Jet 256000 EFlowTrack 256000}
+# set AutoFlush -30000000
+# set AutoSave 10000000
+# set ImplicitMT true
+# set ImplicitMTThreads 4
+
+# modules whose exported arrays are neither imported downstream nor written
+# are reported at initialization; SkipUnusedModules also skips them per event
+# (this changes the random sequence of the modules running after them)
+# set SkipUnusedModules true
+# modules modifying their input candidates can be kept explicitly
+# set KeepModules {PhotonIsolation}
+
+#######################################
+# Input settings for DelphesROOT (optional)
+#######################################
+
+# set SkipEvents 0
+# set MaxEvents 10000
+# set SelectiveRead true
+# set TreeCacheSize 50000000
+# set ParallelUnzip true
+
+# store the generator-level particles for DelphesParticleCache (HepMC, LHEF and STDHEP readers)
+# set ParticleCacheFile particles.cache
+
+# seek to SkipEvents with an input_file.index event index, and save a checkpoint
+# every CheckpointInterval events to resume an interrupted job (HepMC, LHEF and STDHEP readers)
+# set EventIndex true
+# set CheckpointFile delphes.checkpoint
+# set CheckpointInterval 1000
+
+# DelphesPythia8: generate on GeneratorThreads threads with independent Pythia8
+# instances, each event reseeded from Random:seed and its event number
+# (requires Random:setSeed = on and Random:seed >= 0 in the Pythia8 card,
+# the output is reproducible for a given number of threads)
+# set GeneratorThreads 4
+# set GeneratorBufferSize 100
+
 #################################
 # Propagate particles in cylinder
 #################################
@@ -88,6 +137,10 @@ module Efficiency ChargedHadronTrackingEfficiency {
   set InputArray ParticlePropagator/chargedHadrons
   set OutputArray chargedHadrons
 
+  # optional: evaluate the formula on a (pt, eta) grid built at initialisation when it is
+  # piecewise-constant, i.e. pt and eta only appear in comparisons with constants (also in IdentificationMap)
+  # set CompileFormulas true
+
   # add EfficiencyFormula {efficiency formula as a function of eta and pt}
 
   # tracking efficiency formula for charged hadrons
@@ -773,10 +826,35 @@ module PseudoBTagScore PseudoBTagScore {
   set PTBins     {20 30 40 50 60 70 80 90 100 120 140 160 180 200 250 300 400 600 1000}
   set AbsEtaBins {0.0 0.5 1.0 1.5 2.0 2.5}
 
+  # optional: tables compiled by belphes-examples/scripts/compile_btagscore_tables.cpp,
+  # mapped in memory instead of reading the histogram files, the bins above must match
+  # set Jet_btagDeepFlavB_table "btagscore_histograms/JetBtagDeepFlavB_Tables.bin"
+
+  # optional: if non-zero, samples smooth scores from monotone splines of the inverse
+  # cumulative distributions with this number of knot intervals, instead of the binned ones
+  set SmoothKnots 0
+
+  # optional: correlates the scores of the jets of an event with a Gaussian copula,
+  # the correlation is a formula of npu (number of pile-up vertices in PileUpInputArray,
+  # the hard-scatter vertex is not counted), njets and ht (scalar sum of the jet PT),
+  # PileUpMerger must be added to the ExecutionPath to use PileUpMerger/vertices
+  # set CopulaCorrelation {min(0.005*npu, 0.3)}
+  # set PileUpInputArray PileUpMerger/vertices
+
   # optional: if non-zero, seeds the random number generator
   set RandomSeed 0
 }
 
+##############
+# Event filter
+##############
+
+module EventFilter EventFilter {
+  # all selections must be passed, a negative MaxAbsEta or MinBTagScore is not applied
+  # add Selection InputArray MinCount MinPT MaxAbsEta MinBTagScore
+  add Selection JetEnergyScale/jets 2 30.0 2.5 0.2770
+}
+
 #####################################################
 # Find uniquely identified photons/electrons/tau/jets
 #####################################################
@@ -788,6 +866,9 @@ module UniqueObjectFinder UniqueObjectFinder {
   add InputArray ElectronIsolation/electrons electrons
   add InputArray MuonIsolation/muons muons
   add InputArray JetEnergyScale/jets jets
+
+  # same result as the default Overlaps method, in linear time
+  set UseLeafBitmap true
 }
 
 ##################
@@ -821,4 +902,13 @@ module TreeWriter TreeWriter {
 
   add Branch MissingET/momentum MissingET MissingET
   add Branch ScalarHT/energy ScalarHT ScalarHT
+
+  # optional: write plain per-branch arrays instead of TClonesArray branches
+  # set OutputMode Flat
+  # add FlatFields BranchName {Field Field ...}, all fields are written by default
+  # add FlatFields Jet {PT Eta Phi Mass Flavor BTag Jet_btagDeepFlavB Particles}
+
+  # optional: write Particle(s)/Constituents links as row indices
+  # in "<Branch>_<Field>" collections instead of TRef/TRefArray
+  # set IndexLinks true
 }
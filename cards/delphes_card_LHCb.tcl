@@ -61,6 +61,16 @@ module PhotonConversions PhotonConversions {
 			       (abs(z) < 0.0) * (0.00)
 		    }
 
+  # sample the conversion point of prompt photons from cumulative
+  # conversion tables in (eta, phi) computed at initialization,
+  # along the centre ray of each bin: sharp (z, r) boundaries of the
+  # conversion map are smeared over the bin width, photons whose path has
+  # a different number of steps than the ray are stepped through the map
+
+  # set UseConversionTable true
+  # set TableEtaBins 100
+  # set TablePhiBins 32
+
 }
 
 
@@ -27,6 +27,7 @@
 
 #include "classes/DelphesModule.h"
 #include "classes/DelphesFactory.h"
+#include "classes/DelphesDensityGrid.h"
 
 #include "classes/SortableObject.h"
 #include "classes/DelphesClasses.h"
@@ -39,6 +40,7 @@
 
 #pragma link C++ class DelphesModule+;
 #pragma link C++ class DelphesFactory+;
+#pragma link C++ class DelphesDensityGrid+;
 
 #pragma link C++ class SortableObject+;
 
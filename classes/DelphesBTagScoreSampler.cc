@@ -0,0 +1,559 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesBTagScoreSampler
+ *
+ *  Pseudo b-tag score sampler shared by the PseudoBTagScore module
+ *  and the root2btagscore converter.
+ *
+ *  The score histograms hist_eta[X]_pt[Y] of the b and non-b files
+ *  are converted to cumulative distribution tables,
+ *  sampled in the same way as TH1::GetRandom.
+ *
+ *  The tables and the PT and |eta| bin edges form a single binary image,
+ *  that can be written to a file and memory-mapped by later jobs.
+ *
+ *  Optionally, the inverse of each table is replaced by a monotone cubic
+ *  spline on a fixed grid of knots, giving smooth unbinned scores.
+ *
+ */
+
+#include "classes/DelphesBTagScoreSampler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TMath.h"
+#include "TString.h"
+
+using namespace std;
+
+// The binary image starts with this header, followed by the PT and |eta| bin edges,
+// the offsets and sizes of the tables, then the bin edges and the cumulative sums
+// of all the tables. The values are stored in the native byte order, so that the
+// image can be used in place once memory-mapped.
+struct TBTagScoreHeader
+{
+  char magic[8];
+  UInt_t version;
+  UInt_t byteOrder;
+  Int_t numberOfPTBins;
+  Int_t numberOfEtaBins;
+  Long64_t numberOfValues;
+};
+
+static_assert(sizeof(TBTagScoreHeader) % sizeof(Double_t) == 0, "unaligned header");
+
+static const char kMagic[8] = "BTAGCDF";
+static const UInt_t kVersion = 1;
+static const UInt_t kByteOrder = 0x01020304;
+
+//------------------------------------------------------------------------------
+
+DelphesBTagScoreSampler::DelphesBTagScoreSampler() :
+  fMap(0), fMapSize(0), fImage(0), fImageSize(0),
+  fNumberOfPTBins(0), fNumberOfEtaBins(0),
+  fPTBins(0), fAbsEtaBins(0), fOffset(0), fSize(0), fEdges(0), fCDF(0),
+  fNumberOfKnots(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesBTagScoreSampler::~DelphesBTagScoreSampler()
+{
+  Unmap();
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::Unmap()
+{
+  if(fMap) munmap(fMap, fMapSize);
+  fMap = 0;
+  fMapSize = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::SetBins(const vector<Double_t> &ptBins, const vector<Double_t> &absEtaBins)
+{
+  stringstream message;
+
+  if(ptBins.size() < 2 || absEtaBins.size() < 2)
+  {
+    message << "at least two PT and two |eta| bin edges are required";
+    throw runtime_error(message.str());
+  }
+
+  fPendingPTBins = ptBins;
+  fPendingAbsEtaBins = absEtaBins;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::ReadHistograms(const char *fileNameB, const char *fileNameNonB)
+{
+  stringstream message;
+  const char *fileNames[2] = {fileNameNonB, fileNameB};
+  TFile *file;
+  TH1 *hist;
+  TString name;
+  Int_t numberOfPTBins, numberOfEtaBins, numberOfTables, flavor, i, j;
+  vector<Double_t> edges, cdf;
+  vector<Long64_t> offsets, sizes;
+  TBTagScoreHeader header;
+  Long64_t words;
+  Double_t *data;
+
+  numberOfPTBins = fPendingPTBins.size() - 1;
+  numberOfEtaBins = fPendingAbsEtaBins.size() - 1;
+
+  if(numberOfPTBins < 1 || numberOfEtaBins < 1)
+  {
+    message << "PT and |eta| bins must be set before reading histograms";
+    throw runtime_error(message.str());
+  }
+
+  // table index is (flavor * numberOfEtaBins + eta bin) * numberOfPTBins + PT bin,
+  // with flavor 1 for b jets and 0 otherwise
+  for(flavor = 0; flavor < 2; ++flavor)
+  {
+    file = TFile::Open(fileNames[flavor]);
+
+    if(!file || file->IsZombie())
+    {
+      message << "can't open " << fileNames[flavor];
+      throw runtime_error(message.str());
+    }
+
+    for(i = 0; i < numberOfEtaBins; ++i)
+    {
+      for(j = 0; j < numberOfPTBins; ++j)
+      {
+        name.Form("hist_eta%d_pt%d", i, j);
+        hist = dynamic_cast<TH1 *>(file->Get(name));
+
+        if(!hist)
+        {
+          message << "can't find histogram " << name << " in " << fileNames[flavor];
+          delete file;
+          throw runtime_error(message.str());
+        }
+
+        offsets.push_back(cdf.size());
+        sizes.push_back(AddHistogram(hist, edges, cdf));
+      }
+    }
+
+    delete file;
+  }
+
+  // assemble the image
+  numberOfTables = 2 * numberOfEtaBins * numberOfPTBins;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrder = kByteOrder;
+  header.numberOfPTBins = numberOfPTBins;
+  header.numberOfEtaBins = numberOfEtaBins;
+  header.numberOfValues = cdf.size();
+
+  words = sizeof(header) / sizeof(Double_t) + (numberOfPTBins + 1) + (numberOfEtaBins + 1)
+    + 2 * numberOfTables + 2 * header.numberOfValues;
+
+  Unmap();
+  fBuffer.assign(words, 0.0);
+
+  data = &fBuffer[0];
+  memcpy(data, &header, sizeof(header));
+  data += sizeof(header) / sizeof(Double_t);
+
+  copy(fPendingPTBins.begin(), fPendingPTBins.end(), data);
+  data += numberOfPTBins + 1;
+  copy(fPendingAbsEtaBins.begin(), fPendingAbsEtaBins.end(), data);
+  data += numberOfEtaBins + 1;
+
+  memcpy(data, &offsets[0], numberOfTables * sizeof(Long64_t));
+  data += numberOfTables;
+  memcpy(data, &sizes[0], numberOfTables * sizeof(Long64_t));
+  data += numberOfTables;
+
+  if(header.numberOfValues > 0)
+  {
+    copy(edges.begin(), edges.end(), data);
+    data += header.numberOfValues;
+    copy(cdf.begin(), cdf.end(), data);
+  }
+
+  SetImage(reinterpret_cast<const char *>(&fBuffer[0]), words * sizeof(Double_t), "histograms");
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesBTagScoreSampler::AddHistogram(const TH1 *hist, vector<Double_t> &edges, vector<Double_t> &cdf)
+{
+  Int_t i, size;
+  Double_t sum, content;
+
+  size = hist->GetNbinsX();
+
+  // same conditions as TH1::ComputeIntegral, an empty table always returns 0
+  sum = 0.0;
+  for(i = 1; i <= size; ++i)
+  {
+    content = hist->GetBinContent(i);
+    if(content < 0.0)
+    {
+      sum = 0.0;
+      break;
+    }
+    sum += content;
+  }
+
+  if(sum == 0.0) return 0;
+
+  cdf.push_back(0.0);
+  edges.push_back(hist->GetXaxis()->GetBinLowEdge(1));
+
+  content = 0.0;
+  for(i = 1; i <= size; ++i)
+  {
+    content += hist->GetBinContent(i);
+    cdf.push_back(content / sum);
+    edges.push_back(hist->GetXaxis()->GetBinUpEdge(i));
+  }
+
+  return size;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::SetImage(const char *data, Long64_t size, const char *name)
+{
+  stringstream message;
+  TBTagScoreHeader header;
+  Long64_t expected, numberOfTables, i;
+  const Double_t *values;
+
+  if(size < Long64_t(sizeof(header)))
+  {
+    message << "invalid b-tag score tables in " << name;
+    throw runtime_error(message.str());
+  }
+
+  memcpy(&header, data, sizeof(header));
+
+  if(memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+  {
+    message << "invalid b-tag score tables in " << name;
+    throw runtime_error(message.str());
+  }
+
+  if(header.version != kVersion)
+  {
+    message << "unsupported version " << header.version << " of b-tag score tables in " << name;
+    throw runtime_error(message.str());
+  }
+
+  if(header.byteOrder != kByteOrder)
+  {
+    message << "b-tag score tables in " << name << " were written with another byte order";
+    throw runtime_error(message.str());
+  }
+
+  numberOfTables = 2 * Long64_t(header.numberOfEtaBins) * header.numberOfPTBins;
+  expected = sizeof(header) + sizeof(Double_t) * ((header.numberOfPTBins + 1) + (header.numberOfEtaBins + 1)
+    + 2 * numberOfTables + 2 * header.numberOfValues);
+
+  if(header.numberOfPTBins < 1 || header.numberOfEtaBins < 1 || header.numberOfValues < 0 || size != expected)
+  {
+    message << "truncated or corrupted b-tag score tables in " << name;
+    throw runtime_error(message.str());
+  }
+
+  values = reinterpret_cast<const Double_t *>(data + sizeof(header));
+
+  fNumberOfPTBins = header.numberOfPTBins;
+  fNumberOfEtaBins = header.numberOfEtaBins;
+
+  fPTBins = values;
+  values += fNumberOfPTBins + 1;
+  fAbsEtaBins = values;
+  values += fNumberOfEtaBins + 1;
+
+  fOffset = reinterpret_cast<const Long64_t *>(values);
+  values += numberOfTables;
+  fSize = reinterpret_cast<const Long64_t *>(values);
+  values += numberOfTables;
+
+  fEdges = values;
+  values += header.numberOfValues;
+  fCDF = values;
+
+  for(i = 0; i < numberOfTables; ++i)
+  {
+    if(fSize[i] < 0 || (fSize[i] > 0 && (fOffset[i] < 0 || fOffset[i] + fSize[i] + 1 > header.numberOfValues)))
+    {
+      message << "corrupted b-tag score tables in " << name;
+      throw runtime_error(message.str());
+    }
+  }
+
+  fImage = data;
+  fImageSize = size;
+
+  // splines of previous tables
+  fNumberOfKnots = 0;
+  fSpline.clear();
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::WriteTables(const char *fileName) const
+{
+  stringstream message;
+  FILE *file;
+
+  if(!fImage)
+  {
+    message << "no b-tag score tables to write";
+    throw runtime_error(message.str());
+  }
+
+  file = fopen(fileName, "wb");
+
+  if(file == NULL)
+  {
+    message << "can't open " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  if(fwrite(fImage, 1, fImageSize, file) != size_t(fImageSize) || fclose(file) != 0)
+  {
+    message << "can't write " << fileName;
+    throw runtime_error(message.str());
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::MapTables(const char *fileName)
+{
+  stringstream message;
+  struct stat status;
+  void *map;
+  int fd;
+
+  fd = open(fileName, O_RDONLY);
+
+  if(fd < 0)
+  {
+    message << "can't open " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  if(fstat(fd, &status) != 0 || status.st_size == 0)
+  {
+    close(fd);
+    message << "can't read " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  // read-only shared mapping, the pages are shared by all the processes using the file
+  map = mmap(0, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if(map == MAP_FAILED)
+  {
+    message << "can't map " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  Unmap();
+  fBuffer.clear();
+
+  fMap = map;
+  fMapSize = status.st_size;
+
+  SetImage(static_cast<const char *>(fMap), fMapSize, fileName);
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t DelphesBTagScoreSampler::HasBins(const vector<Double_t> &ptBins, const vector<Double_t> &absEtaBins) const
+{
+  return ptBins.size() == size_t(fNumberOfPTBins + 1) && absEtaBins.size() == size_t(fNumberOfEtaBins + 1)
+    && equal(ptBins.begin(), ptBins.end(), fPTBins) && equal(absEtaBins.begin(), absEtaBins.end(), fAbsEtaBins);
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesBTagScoreSampler::FindTable(Double_t pt, Double_t eta, Int_t flavor) const
+{
+  const Double_t *itPT, *itEta;
+
+  itPT = upper_bound(fPTBins, fPTBins + fNumberOfPTBins + 1, pt);
+  if(itPT == fPTBins || itPT == fPTBins + fNumberOfPTBins + 1) return -1;
+
+  itEta = upper_bound(fAbsEtaBins, fAbsEtaBins + fNumberOfEtaBins + 1, TMath::Abs(eta));
+  if(itEta == fAbsEtaBins || itEta == fAbsEtaBins + fNumberOfEtaBins + 1) return -1;
+
+  return ((flavor == 5 ? 1 : 0) * fNumberOfEtaBins + (itEta - fAbsEtaBins - 1)) * fNumberOfPTBins
+    + (itPT - fPTBins - 1);
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesBTagScoreSampler::BinnedQuantile(Int_t table, Double_t u) const
+{
+  Long64_t size, bin;
+  const Double_t *cdf, *edges;
+
+  size = fSize[table];
+  if(size == 0) return 0.0;
+
+  cdf = fCDF + fOffset[table];
+  edges = fEdges + fOffset[table];
+
+  // last bin with cdf[bin] <= u, as TMath::BinarySearch in TH1::GetRandom
+  bin = upper_bound(cdf, cdf + size, u) - cdf - 1;
+  if(bin < 0) bin = 0;
+
+  if(u > cdf[bin])
+  {
+    return edges[bin] + (edges[bin + 1] - edges[bin]) * (u - cdf[bin]) / (cdf[bin + 1] - cdf[bin]);
+  }
+
+  return edges[bin];
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::Smooth(Int_t numberOfKnots)
+{
+  Int_t numberOfTables, table, k;
+  vector<Double_t> y, slope;
+  Double_t left, right, *coefficients;
+
+  fNumberOfKnots = 0;
+  fSpline.clear();
+
+  if(numberOfKnots <= 0) return;
+
+  numberOfTables = 2 * fNumberOfEtaBins * fNumberOfPTBins;
+
+  fSpline.assign(4 * numberOfKnots * numberOfTables, 0.0);
+  y.resize(numberOfKnots + 1);
+  slope.resize(numberOfKnots + 1);
+
+  for(table = 0; table < numberOfTables; ++table)
+  {
+    if(IsEmpty(table)) continue;
+
+    // knots on the binned inverse
+    for(k = 0; k <= numberOfKnots; ++k)
+    {
+      y[k] = BinnedQuantile(table, Double_t(k) / numberOfKnots);
+    }
+
+    // Fritsch-Butland slopes (harmonic mean of the neighbouring differences)
+    // keep the spline monotone and inside the knot values
+    slope[0] = y[1] - y[0];
+    slope[numberOfKnots] = y[numberOfKnots] - y[numberOfKnots - 1];
+    for(k = 1; k < numberOfKnots; ++k)
+    {
+      left = y[k] - y[k - 1];
+      right = y[k + 1] - y[k];
+      slope[k] = (left > 0.0 && right > 0.0) ? 2.0 * left * right / (left + right) : 0.0;
+    }
+
+    // cubic Hermite polynomial in t = u * numberOfKnots - k
+    coefficients = &fSpline[4 * numberOfKnots * table];
+    for(k = 0; k < numberOfKnots; ++k)
+    {
+      right = y[k + 1] - y[k];
+      coefficients[4 * k] = y[k];
+      coefficients[4 * k + 1] = slope[k];
+      coefficients[4 * k + 2] = 3.0 * right - 2.0 * slope[k] - slope[k + 1];
+      coefficients[4 * k + 3] = slope[k] + slope[k + 1] - 2.0 * right;
+    }
+  }
+
+  fNumberOfKnots = numberOfKnots;
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesBTagScoreSampler::SmoothQuantile(Int_t table, Double_t u) const
+{
+  Int_t k;
+  Double_t t;
+  const Double_t *coefficients;
+
+  if(IsEmpty(table)) return 0.0;
+
+  t = u * fNumberOfKnots;
+  k = Int_t(t);
+  if(k >= fNumberOfKnots) k = fNumberOfKnots - 1;
+  if(k < 0) k = 0;
+  t -= k;
+
+  coefficients = &fSpline[4 * (fNumberOfKnots * table + k)];
+
+  return coefficients[0] + t * (coefficients[1] + t * (coefficients[2] + t * coefficients[3]));
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::Sample(Int_t n, const Float_t *pt, const Float_t *eta, const UInt_t *flavor,
+  const Double_t *u, Float_t *score) const
+{
+  Int_t i, table;
+
+  for(i = 0; i < n; ++i)
+  {
+    table = FindTable(pt[i], eta[i], flavor[i]);
+    score[i] = (table < 0) ? -1.0 : Quantile(table, u[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesBTagScoreSampler::Sample(Int_t n, const Double_t *pt, const Double_t *eta, const UInt_t *flavor,
+  const Double_t *u, Float_t *score) const
+{
+  Int_t i, table;
+
+  for(i = 0; i < n; ++i)
+  {
+    table = FindTable(pt[i], eta[i], flavor[i]);
+    score[i] = (table < 0) ? -1.0 : Quantile(table, u[i]);
+  }
+}
@@ -0,0 +1,129 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesBTagScoreSampler_h
+#define DelphesBTagScoreSampler_h
+
+/** \class DelphesBTagScoreSampler
+ *
+ *  Pseudo b-tag score sampler shared by the PseudoBTagScore module
+ *  and the root2btagscore converter.
+ *
+ *  The score histograms hist_eta[X]_pt[Y] of the b and non-b files
+ *  are converted to cumulative distribution tables,
+ *  sampled in the same way as TH1::GetRandom.
+ *
+ *  The tables and the PT and |eta| bin edges form a single binary image,
+ *  that can be written to a file and memory-mapped by later jobs.
+ *
+ *  Optionally, the inverse of each table is replaced by a monotone cubic
+ *  spline on a fixed grid of knots, giving smooth unbinned scores.
+ *
+ */
+
+#include "Rtypes.h"
+
+#include <vector>
+
+class TH1;
+
+class DelphesBTagScoreSampler
+{
+public:
+  DelphesBTagScoreSampler();
+  ~DelphesBTagScoreSampler();
+
+  void SetBins(const std::vector<Double_t> &ptBins, const std::vector<Double_t> &absEtaBins);
+
+  void ReadHistograms(const char *fileNameB, const char *fileNameNonB);
+
+  // compiled tables, see belphes-examples/scripts/compile_btagscore_tables.cpp
+  void WriteTables(const char *fileName) const;
+  void MapTables(const char *fileName);
+
+  // true if the bin edges of the tables are the given ones
+  Bool_t HasBins(const std::vector<Double_t> &ptBins, const std::vector<Double_t> &absEtaBins) const;
+
+  Int_t GetNumberOfPTBins() const { return fNumberOfPTBins; }
+  Int_t GetNumberOfEtaBins() const { return fNumberOfEtaBins; }
+
+  // table index for a jet, -1 outside the PT and |eta| bins
+  Int_t FindTable(Double_t pt, Double_t eta, Int_t flavor) const;
+
+  // tables of empty histograms always return 0
+  Bool_t IsEmpty(Int_t table) const { return fSize[table] == 0; }
+
+  // fit the inverse of all tables with monotone cubic splines on numberOfKnots + 1
+  // equidistant knots in [0, 1], 0 goes back to the binned inverse
+  void Smooth(Int_t numberOfKnots);
+
+  // inverse cumulative distribution for u in [0, 1]
+  Double_t Quantile(Int_t table, Double_t u) const
+  {
+    return fNumberOfKnots > 0 ? SmoothQuantile(table, u) : BinnedQuantile(table, u);
+  }
+
+  Double_t BinnedQuantile(Int_t table, Double_t u) const;
+  Double_t SmoothQuantile(Int_t table, Double_t u) const;
+
+  // scores of n jets, one uniform number u per jet, -1 outside the bins
+  void Sample(Int_t n, const Float_t *pt, const Float_t *eta, const UInt_t *flavor,
+    const Double_t *u, Float_t *score) const;
+  void Sample(Int_t n, const Double_t *pt, const Double_t *eta, const UInt_t *flavor,
+    const Double_t *u, Float_t *score) const;
+
+private:
+  void Unmap();
+
+  void SetImage(const char *data, Long64_t size, const char *name);
+
+  // appends the bin edges and cumulative sums, returns the number of bins or 0 if empty
+  Int_t AddHistogram(const TH1 *hist, std::vector<Double_t> &edges, std::vector<Double_t> &cdf);
+
+  std::vector<Double_t> fPendingPTBins;
+  std::vector<Double_t> fPendingAbsEtaBins;
+
+  // image built from histograms, Double_t keeps the tables aligned
+  std::vector<Double_t> fBuffer;
+
+  void *fMap;
+  Long64_t fMapSize;
+
+  const char *fImage;
+  Long64_t fImageSize;
+
+  Int_t fNumberOfPTBins;
+  Int_t fNumberOfEtaBins;
+
+  const Double_t *fPTBins;
+  const Double_t *fAbsEtaBins;
+
+  // bin edges and cumulative sums of table i start at fOffset[i],
+  // with fSize[i] + 1 values each
+  const Long64_t *fOffset;
+  const Long64_t *fSize;
+
+  const Double_t *fEdges;
+  const Double_t *fCDF;
+
+  // 4 polynomial coefficients per knot interval and table
+  Int_t fNumberOfKnots;
+  std::vector<Double_t> fSpline;
+};
+
+#endif /* DelphesBTagScoreSampler_h */
@@ -0,0 +1,150 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesCheckpoint
+ *
+ *  Saves and restores the input position and the state of
+ *  the random number generator of an interrupted job
+ *
+ */
+
+#include "classes/DelphesCheckpoint.h"
+
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TParameter.h"
+#include "TRandom.h"
+#include "TSystem.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+DelphesCheckpoint::DelphesCheckpoint(const char *fileName) :
+  fFileName(fileName), fInput(-1), fOffset(0), fEventCounter(0), fRandom(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesCheckpoint::~DelphesCheckpoint()
+{
+  if(fRandom) delete fRandom;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesCheckpoint::ReadCheckpoint()
+{
+  stringstream message;
+  TDirectory *currentDirectory = gDirectory;
+  TFile *file;
+  TParameter<Int_t> *input;
+  TParameter<Long64_t> *offset, *eventCounter;
+
+  if(gSystem->AccessPathName(fFileName)) return false;
+
+  file = TFile::Open(fFileName);
+
+  if(!file || file->IsZombie())
+  {
+    message << "can't open checkpoint file " << fFileName;
+    throw runtime_error(message.str());
+  }
+
+  input = static_cast<TParameter<Int_t> *>(file->Get("Input"));
+  offset = static_cast<TParameter<Long64_t> *>(file->Get("Offset"));
+  eventCounter = static_cast<TParameter<Long64_t> *>(file->Get("EventCounter"));
+  fRandom = static_cast<TRandom *>(file->Get("Random"));
+
+  if(!input || !offset || !eventCounter || !fRandom)
+  {
+    message << "corrupted checkpoint file " << fFileName;
+    throw runtime_error(message.str());
+  }
+
+  fInput = input->GetVal();
+  fOffset = offset->GetVal();
+  fEventCounter = eventCounter->GetVal();
+
+  delete input;
+  delete offset;
+  delete eventCounter;
+
+  file->Close();
+  delete file;
+
+  currentDirectory->cd();
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesCheckpoint::WriteCheckpoint(Int_t input, Long64_t offset, Long64_t eventCounter)
+{
+  stringstream message;
+  TDirectory *currentDirectory = gDirectory;
+  TString tmpName = fFileName + ".tmp";
+  TFile *file;
+
+  file = TFile::Open(tmpName, "RECREATE");
+
+  if(!file || file->IsZombie())
+  {
+    message << "can't create checkpoint file " << tmpName;
+    throw runtime_error(message.str());
+  }
+
+  TParameter<Int_t>("Input", input).Write();
+  TParameter<Long64_t>("Offset", offset).Write();
+  TParameter<Long64_t>("EventCounter", eventCounter).Write();
+  gRandom->Write("Random");
+
+  file->Close();
+  delete file;
+
+  currentDirectory->cd();
+
+  // replace the previous checkpoint only when the new one is complete
+  gSystem->Rename(tmpName, fFileName);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesCheckpoint::RemoveCheckpoint()
+{
+  if(!gSystem->AccessPathName(fFileName)) gSystem->Unlink(fFileName);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesCheckpoint::RestoreRandom()
+{
+  if(!fRandom) return;
+
+  delete gRandom;
+  gRandom = fRandom;
+  fRandom = 0;
+}
+
+//------------------------------------------------------------------------------
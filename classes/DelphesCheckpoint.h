@@ -0,0 +1,62 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesCheckpoint_h
+#define DelphesCheckpoint_h
+
+/** \class DelphesCheckpoint
+ *
+ *  Saves and restores the input position and the state of
+ *  the random number generator of an interrupted job
+ *
+ */
+
+#include "TString.h"
+
+class TRandom;
+
+class DelphesCheckpoint
+{
+public:
+  DelphesCheckpoint(const char *fileName);
+
+  ~DelphesCheckpoint();
+
+  bool ReadCheckpoint();
+
+  void WriteCheckpoint(Int_t input, Long64_t offset, Long64_t eventCounter);
+
+  void RemoveCheckpoint();
+
+  void RestoreRandom();
+
+  Int_t GetInput() const { return fInput; }
+  Long64_t GetOffset() const { return fOffset; }
+  Long64_t GetEventCounter() const { return fEventCounter; }
+
+private:
+  TString fFileName;
+
+  Int_t fInput;
+  Long64_t fOffset;
+  Long64_t fEventCounter;
+
+  TRandom *fRandom;
+};
+
+#endif // DelphesCheckpoint_h
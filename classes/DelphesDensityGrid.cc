@@ -0,0 +1,159 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesDensityGrid
+ *
+ *  Particle multiplicity density in eta-phi bins, filled by ParticleDensity
+ *  and exported so that other modules can query it at any coordinate.
+ *  Bins follow the TAxis numbering (0 is the underflow, n + 1 the overflow),
+ *  and the densities are normalised by the bin area as TH2::Scale(1, "width").
+ *
+ */
+
+#include "classes/DelphesDensityGrid.h"
+#include "classes/DelphesClasses.h"
+
+#include "TMath.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+DelphesDensityGrid::DelphesDensityGrid() :
+  fPhiSize(0), fUseMomentumVector(kFALSE)
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesDensityGrid::~DelphesDensityGrid()
+{
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesDensityGrid::SetAxis(TAxisBins &axis, const vector<Double_t> &edges)
+{
+  Int_t i, n;
+  Double_t width;
+
+  if(edges.size() < 2)
+  {
+    throw runtime_error("density grid needs at least two bin edges per axis");
+  }
+
+  n = edges.size() - 1;
+  for(i = 0; i < n; ++i)
+  {
+    if(edges[i + 1] <= edges[i])
+    {
+      throw runtime_error("density grid bin edges must be increasing");
+    }
+  }
+
+  axis.edges = edges;
+
+  // equal bins are found directly, other bins by binary search
+  width = (edges[n] - edges[0]) / n;
+  axis.inverseWidth = 1.0 / width;
+  axis.uniform = kTRUE;
+  for(i = 1; i < n; ++i)
+  {
+    if(TMath::Abs(edges[i] - edges[0] - i * width) > 1.0E-9 * width) axis.uniform = kFALSE;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesDensityGrid::SetBins(const vector<Double_t> &etaBins, const vector<Double_t> &phiBins)
+{
+  Int_t i, j, nEta, nPhi;
+  Double_t widthEta, widthPhi;
+
+  SetAxis(fEta, etaBins);
+  SetAxis(fPhi, phiBins);
+
+  nEta = etaBins.size() - 1;
+  nPhi = phiBins.size() - 1;
+  fPhiSize = nPhi + 2;
+
+  // underflow and overflow bins use the width of the first and last bins
+
+  fCounts.assign((nEta + 2) * fPhiSize, 0);
+  fInverseArea.resize((nEta + 2) * fPhiSize);
+  for(i = 0; i < nEta + 2; ++i)
+  {
+    widthEta = etaBins[TMath::Min(TMath::Max(i, 1), nEta)] - etaBins[TMath::Min(TMath::Max(i, 1), nEta) - 1];
+    for(j = 0; j < fPhiSize; ++j)
+    {
+      widthPhi = phiBins[TMath::Min(TMath::Max(j, 1), nPhi)] - phiBins[TMath::Min(TMath::Max(j, 1), nPhi) - 1];
+      fInverseArea[i * fPhiSize + j] = 1.0 / (widthEta * widthPhi);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesDensityGrid::Reset()
+{
+  fill(fCounts.begin(), fCounts.end(), 0);
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesDensityGrid::FindAxisBin(const TAxisBins &axis, Double_t x)
+{
+  const vector<Double_t> &edges = axis.edges;
+  Int_t i, n = edges.size() - 1;
+
+  if(!(x >= edges[0])) return 0;
+  if(x >= edges[n]) return n + 1;
+
+  if(axis.uniform)
+  {
+    i = TMath::Min(Int_t((x - edges[0]) * axis.inverseWidth), n - 1);
+
+    // correct for rounding near the bin edges
+    if(x < edges[i]) --i;
+    else if(x >= edges[i + 1]) ++i;
+
+    return i + 1;
+  }
+
+  return upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesDensityGrid::FindBin(Double_t eta, Double_t phi) const
+{
+  return FindAxisBin(fEta, eta) * fPhiSize + FindAxisBin(fPhi, phi);
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesDensityGrid::FindBin(const Candidate *candidate) const
+{
+  const TLorentzVector &vector = fUseMomentumVector ? candidate->Momentum : candidate->Position;
+  return FindBin(vector.Eta(), vector.Phi());
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,80 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesDensityGrid_h
+#define DelphesDensityGrid_h
+
+/** \class DelphesDensityGrid
+ *
+ *  Particle multiplicity density in eta-phi bins, filled by ParticleDensity
+ *  and exported so that other modules can query it at any coordinate.
+ *  Bins follow the TAxis numbering (0 is the underflow, n + 1 the overflow),
+ *  and the densities are normalised by the bin area as TH2::Scale(1, "width").
+ *
+ */
+
+#include "TObject.h"
+
+#include <vector>
+
+class Candidate;
+
+class DelphesDensityGrid: public TObject
+{
+public:
+  DelphesDensityGrid();
+  ~DelphesDensityGrid();
+
+  void SetBins(const std::vector<Double_t> &etaBins, const std::vector<Double_t> &phiBins);
+  void SetUseMomentumVector(Bool_t useMomentumVector) { fUseMomentumVector = useMomentumVector; }
+
+  void Reset();
+
+  Int_t FindBin(Double_t eta, Double_t phi) const;
+  Int_t FindBin(const Candidate *candidate) const;
+
+  void Fill(Int_t bin) { ++fCounts[bin]; }
+
+  Double_t GetDensity(Int_t bin) const { return fCounts[bin] * fInverseArea[bin]; }
+  Double_t GetDensity(Double_t eta, Double_t phi) const { return GetDensity(FindBin(eta, phi)); }
+  Double_t GetDensity(const Candidate *candidate) const { return GetDensity(FindBin(candidate)); }
+
+private:
+  struct TAxisBins
+  {
+    std::vector<Double_t> edges;
+    Double_t inverseWidth;
+    Bool_t uniform;
+  };
+
+  static void SetAxis(TAxisBins &axis, const std::vector<Double_t> &edges);
+  static Int_t FindAxisBin(const TAxisBins &axis, Double_t x);
+
+  TAxisBins fEta, fPhi; //!
+
+  Int_t fPhiSize; //!
+
+  Bool_t fUseMomentumVector; //!
+
+  std::vector<Int_t> fCounts; //!
+  std::vector<Double_t> fInverseArea; //!
+
+  ClassDef(DelphesDensityGrid, 1)
+};
+
+#endif /* DelphesDensityGrid_h */
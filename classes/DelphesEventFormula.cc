@@ -0,0 +1,83 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesEventFormula
+ *
+ *  Formula of event variables: npu (number of pile-up vertices),
+ *  njets (number of jets) and ht (scalar sum of the jet PT)
+ *
+ */
+
+#include "classes/DelphesEventFormula.h"
+
+#include "TString.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+DelphesEventFormula::DelphesEventFormula() :
+  TFormula()
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesEventFormula::DelphesEventFormula(const char * /*name*/, const char * /*expression*/) :
+  TFormula()
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesEventFormula::~DelphesEventFormula()
+{
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesEventFormula::Compile(const char *expression)
+{
+  TString buffer;
+  const char *it;
+  for(it = expression; *it; ++it)
+  {
+    if(*it == ' ' || *it == '\t' || *it == '\r' || *it == '\n' || *it == '\\') continue;
+    buffer.Append(*it);
+  }
+  buffer.ReplaceAll("npu", "x");
+  buffer.ReplaceAll("njets", "y");
+  buffer.ReplaceAll("ht", "z");
+  if(TFormula::Compile(buffer) != 0)
+  {
+    throw runtime_error("Invalid formula.");
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesEventFormula::Eval(Double_t npu, Double_t njets, Double_t ht)
+{
+  Double_t x[3] = {npu, njets, ht};
+  return EvalPar(x);
+}
+
+//------------------------------------------------------------------------------
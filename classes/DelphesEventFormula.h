@@ -0,0 +1,45 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesEventFormula_h
+#define DelphesEventFormula_h
+
+#include "TFormula.h"
+
+/** \class DelphesEventFormula
+ *
+ *  Formula of event variables: npu (number of pile-up vertices),
+ *  njets (number of jets) and ht (scalar sum of the jet PT)
+ *
+ */
+
+class DelphesEventFormula: public TFormula
+{
+public:
+  DelphesEventFormula();
+
+  DelphesEventFormula(const char *name, const char *expression);
+
+  ~DelphesEventFormula();
+
+  Int_t Compile(const char *expression);
+
+  Double_t Eval(Double_t npu, Double_t njets = 0, Double_t ht = 0);
+};
+
+#endif /* DelphesEventFormula_h */
@@ -0,0 +1,171 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesEventIndex
+ *
+ *  Byte offsets of the events in an input file,
+ *  stored next to the input file for later runs
+ *
+ */
+
+#include "classes/DelphesEventIndex.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "classes/DelphesXDRReader.h"
+#include "classes/DelphesXDRWriter.h"
+
+using namespace std;
+
+static const int kBufferSize = 16384;
+
+//------------------------------------------------------------------------------
+
+DelphesEventIndex::DelphesEventIndex() :
+  fBuffer(0)
+{
+  fBuffer = new char[kBufferSize];
+}
+
+//------------------------------------------------------------------------------
+
+DelphesEventIndex::~DelphesEventIndex()
+{
+  if(fBuffer) delete[] fBuffer;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesEventIndex::Clear()
+{
+  fOffsets.clear();
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesEventIndex::ReadIndex(const char *fileName, int64_t inputSize)
+{
+  FILE *indexFile;
+  DelphesXDRReader reader;
+  int64_t entries, size, i;
+
+  Clear();
+
+  indexFile = fopen(fileName, "rb");
+
+  if(indexFile == NULL) return false;
+
+  reader.SetFile(indexFile);
+
+  // read size of the indexed file and number of events
+  fseeko(indexFile, -16, SEEK_END);
+  reader.ReadValue(&size, 8);
+  reader.ReadValue(&entries, 8);
+
+  // the index is out of date if the input file has changed
+  if(size != inputSize || entries < 0 || ftello(indexFile) < 16 + 8 * entries)
+  {
+    fclose(indexFile);
+    return false;
+  }
+
+  fOffsets.resize(entries);
+  fseeko(indexFile, -16 - 8 * entries, SEEK_END);
+  for(i = 0; i < entries; ++i)
+  {
+    reader.ReadValue(&fOffsets[i], 8);
+  }
+
+  fclose(indexFile);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesEventIndex::WriteIndex(const char *fileName, int64_t inputSize)
+{
+  stringstream message;
+  FILE *indexFile;
+  DelphesXDRWriter writer;
+  int64_t entries;
+  vector<int64_t>::iterator itOffsets;
+
+  indexFile = fopen(fileName, "wb");
+
+  if(indexFile == NULL)
+  {
+    message << "can't open event index file " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  writer.SetFile(indexFile);
+
+  for(itOffsets = fOffsets.begin(); itOffsets != fOffsets.end(); ++itOffsets)
+  {
+    writer.WriteValue(&(*itOffsets), 8);
+  }
+
+  entries = fOffsets.size();
+  writer.WriteValue(&inputSize, 8);
+  writer.WriteValue(&entries, 8);
+
+  fclose(indexFile);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesEventIndex::BuildIndex(FILE *inputFile, const char *marker)
+{
+  int64_t offset;
+  size_t length, markerLength;
+  bool lineStart;
+
+  Clear();
+
+  markerLength = strlen(marker);
+
+  // record the offsets of the lines starting with the event marker,
+  // without parsing the events
+  fseeko(inputFile, 0, SEEK_SET);
+  offset = 0;
+  lineStart = true;
+  while(fgets(fBuffer, kBufferSize, inputFile))
+  {
+    length = strlen(fBuffer);
+
+    if(lineStart && strncmp(fBuffer, marker, markerLength) == 0)
+    {
+      AddEntry(offset);
+    }
+
+    lineStart = (length > 0 && fBuffer[length - 1] == '\n');
+    offset += length;
+  }
+
+  clearerr(inputFile);
+  fseeko(inputFile, 0, SEEK_SET);
+}
+
+//------------------------------------------------------------------------------
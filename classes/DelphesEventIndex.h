@@ -0,0 +1,60 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesEventIndex_h
+#define DelphesEventIndex_h
+
+/** \class DelphesEventIndex
+ *
+ *  Byte offsets of the events in an input file,
+ *  stored next to the input file for later runs
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+class DelphesEventIndex
+{
+public:
+  DelphesEventIndex();
+
+  ~DelphesEventIndex();
+
+  void Clear();
+
+  bool ReadIndex(const char *fileName, int64_t inputSize);
+
+  void WriteIndex(const char *fileName, int64_t inputSize);
+
+  void BuildIndex(FILE *inputFile, const char *marker);
+
+  void AddEntry(int64_t offset) { fOffsets.push_back(offset); }
+
+  int64_t GetEntries() const { return fOffsets.size(); }
+  int64_t GetOffset(int64_t entry) const { return fOffsets[entry]; }
+
+private:
+  std::vector<int64_t> fOffsets;
+
+  char *fBuffer;
+};
+
+#endif // DelphesEventIndex_h
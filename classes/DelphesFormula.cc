@@ -80,15 +80,21 @@ Int_t DelphesFormula::Compile(const char *expression)
 //------------------------------------------------------------------------------
 
 Double_t DelphesFormula::Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy, Candidate *candidate)
+{
+  return Eval(pt, eta, phi, energy, candidate, candidate ? candidate->ParticleDensity : 0.0);
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesFormula::Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy, Candidate *candidate, Double_t density)
 {
 
-  Double_t d0 = 0., dz = 0., ctgTheta = 0., radius = 0., density = 0.;
+  Double_t d0 = 0., dz = 0., ctgTheta = 0., radius = 0.;
   if (candidate) {
     d0 = candidate->D0;
     dz = candidate->DZ;
     ctgTheta = candidate->CtgTheta;
     radius = candidate->Position.Pt();
-    density = candidate->ParticleDensity;
   }
     
   Double_t x[4] = {pt, eta, phi, energy};
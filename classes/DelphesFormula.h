@@ -35,6 +35,9 @@ public:
   Int_t Compile(const char *expression);
 
   Double_t Eval(Double_t pt, Double_t eta = 0, Double_t phi = 0, Double_t energy = 0, Candidate *candidate = nullptr);
+
+  // density given instead of taken from the candidate
+  Double_t Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy, Candidate *candidate, Double_t density);
 };
 
 #endif /* DelphesFormula_h */
@@ -0,0 +1,273 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesFormulaGrid
+ *
+ *  Piecewise-constant (pt, eta) grid of a DelphesFormula.
+ *
+ *  The cell edges are the constants compared with pt, eta or abs(eta)
+ *  in the expression. The grid is only used when pt and eta appear
+ *  in no other place, so that the formula is constant in each cell.
+ *  The formula is evaluated on the cell edges, in the cells where
+ *  it is not finite, and for all other expressions.
+ *
+ */
+
+#include "classes/DelphesFormulaGrid.h"
+#include "classes/DelphesFormula.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <regex>
+#include <string>
+
+#include <stdlib.h>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+DelphesFormulaGrid::DelphesFormulaGrid() :
+  fFormula(0), fNumberOfConstantCells(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesFormulaGrid::~DelphesFormulaGrid()
+{
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t DelphesFormulaGrid::FindEdges(const char *expression)
+{
+  // a comparison of a variable with a constant, on either side, that is not part
+  // of an arithmetic expression (only parenthesis, logical operators and commas around)
+  static const string number = "([-+]?(?:[0-9]+\\.?[0-9]*|\\.[0-9]+)(?:[eE][-+]?[0-9]+)?)";
+  static const string variable = "(pt|eta|abs\\(eta\\)|fabs\\(eta\\)|TMath::Abs\\(eta\\))";
+  static const string op = "(<=|>=|<|>)";
+  static const regex variableFirst("(?:^|[(&|!,?:])" + variable + op + number + "(?=$|[)&|,?:])");
+  static const regex numberFirst("(?:^|[(&|!,?:])" + number + op + variable + "(?=$|[)&|,?:])");
+  static const regex anyVariable("(?:^|[^A-Za-z0-9_])(pt|eta)(?![A-Za-z0-9_])");
+
+  string buffer = expression;
+  string rest = expression;
+  sregex_iterator it, end;
+  string name;
+  size_t start, length;
+  Double_t value;
+
+  for(it = sregex_iterator(buffer.begin(), buffer.end(), variableFirst); it != end; ++it)
+  {
+    name = (*it)[1];
+    value = strtod((*it)[3].str().c_str(), 0);
+    if(name == "pt")
+    {
+      fPTEdges.push_back(value);
+    }
+    else
+    {
+      fEtaEdges.push_back(value);
+      if(name != "eta") fEtaEdges.push_back(-value);
+    }
+    start = it->position(1);
+    length = it->position(3) + it->length(3) - start;
+    rest.replace(start, length, length, '0');
+  }
+
+  for(it = sregex_iterator(buffer.begin(), buffer.end(), numberFirst); it != end; ++it)
+  {
+    name = (*it)[3];
+    value = strtod((*it)[1].str().c_str(), 0);
+    if(name == "pt")
+    {
+      fPTEdges.push_back(value);
+    }
+    else
+    {
+      fEtaEdges.push_back(value);
+      if(name != "eta") fEtaEdges.push_back(-value);
+    }
+    start = it->position(1);
+    length = it->position(3) + it->length(3) - start;
+    rest.replace(start, length, length, '0');
+  }
+
+  sort(fPTEdges.begin(), fPTEdges.end());
+  fPTEdges.erase(unique(fPTEdges.begin(), fPTEdges.end()), fPTEdges.end());
+
+  sort(fEtaEdges.begin(), fEtaEdges.end());
+  fEtaEdges.erase(unique(fEtaEdges.begin(), fEtaEdges.end()), fEtaEdges.end());
+
+  // the formula is constant in each cell only if all occurrences
+  // of pt and eta are in these comparisons
+  return !regex_search(rest, anyVariable);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesFormulaGrid::SamplePoints(const vector<Double_t> &edges, Int_t cell, vector<Double_t> &points) const
+{
+  static const Double_t fractions[5] = {0.5, 0.013, 0.25, 0.75, 0.987};
+  static const Double_t steps[5] = {0.013, 0.5, 1.0, 10.0, 1000.0};
+  Int_t size = edges.size(), i;
+  Double_t lower, upper, scale, point;
+
+  points.clear();
+
+  if(size == 0)
+  {
+    points.push_back(0.0);
+    for(i = 1; i < 5; ++i)
+    {
+      points.push_back(-1.3 * steps[i]);
+      points.push_back(1.3 * steps[i]);
+    }
+    return;
+  }
+
+  if(cell == 0)
+  {
+    upper = edges[0];
+    scale = max(1.0, fabs(upper));
+    for(i = 0; i < 5; ++i) points.push_back(upper - scale * steps[i]);
+  }
+  else if(cell == size)
+  {
+    lower = edges[size - 1];
+    scale = max(1.0, fabs(lower));
+    for(i = 0; i < 5; ++i) points.push_back(lower + scale * steps[i]);
+  }
+  else
+  {
+    lower = edges[cell - 1];
+    upper = edges[cell];
+    for(i = 0; i < 5; ++i)
+    {
+      point = lower + fractions[i] * (upper - lower);
+      if(point > lower && point < upper) points.push_back(point);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesFormulaGrid::Build(DelphesFormula *formula, const char *expression)
+{
+  static const regex otherVariables("(?:^|[^A-Za-z0-9_])(phi|energy|d0|dz|ctgTheta|radius|density|x|y|z|t)(?![A-Za-z0-9_])");
+  const Double_t nan = numeric_limits<Double_t>::quiet_NaN();
+  vector<Double_t> ptPoints, etaPoints;
+  vector<Double_t>::iterator itPT, itEta;
+  string buffer;
+  const char *it;
+  Int_t numberOfPTCells, numberOfEtaCells, i, j;
+  Double_t value, first;
+  Bool_t constant;
+
+  fFormula = formula;
+  fPTEdges.clear();
+  fEtaEdges.clear();
+  fValues.clear();
+  fNumberOfConstantCells = 0;
+
+  for(it = expression; *it; ++it)
+  {
+    if(*it == ' ' || *it == '\t' || *it == '\r' || *it == '\n' || *it == '\\') continue;
+    buffer += *it;
+  }
+
+  // only pt and eta are on the grid
+  if(regex_search(buffer, otherVariables)) return;
+
+  if(!FindEdges(buffer.c_str()))
+  {
+    fPTEdges.clear();
+    fEtaEdges.clear();
+    return;
+  }
+
+  numberOfPTCells = fPTEdges.size() + 1;
+  numberOfEtaCells = fEtaEdges.size() + 1;
+
+  fValues.assign(numberOfPTCells * numberOfEtaCells, nan);
+
+  // the formula is constant in each cell, the check at a few points
+  // of the cell only guards against an edge missed by FindEdges
+  for(j = 0; j < numberOfEtaCells; ++j)
+  {
+    SamplePoints(fEtaEdges, j, etaPoints);
+    for(i = 0; i < numberOfPTCells; ++i)
+    {
+      SamplePoints(fPTEdges, i, ptPoints);
+      if(ptPoints.empty() || etaPoints.empty()) continue;
+
+      first = fFormula->Eval(ptPoints[0], etaPoints[0]);
+      constant = std::isfinite(first);
+      for(itEta = etaPoints.begin(); constant && itEta != etaPoints.end(); ++itEta)
+      {
+        for(itPT = ptPoints.begin(); constant && itPT != ptPoints.end(); ++itPT)
+        {
+          value = fFormula->Eval(*itPT, *itEta);
+          constant = (value == first);
+        }
+      }
+
+      if(constant)
+      {
+        fValues[j * numberOfPTCells + i] = first;
+        ++fNumberOfConstantCells;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesFormulaGrid::FindValue(Double_t pt, Double_t eta) const
+{
+  const Double_t nan = numeric_limits<Double_t>::quiet_NaN();
+  Int_t i, j;
+
+  if(fValues.empty() || pt != pt || eta != eta) return nan;
+
+  i = upper_bound(fPTEdges.begin(), fPTEdges.end(), pt) - fPTEdges.begin();
+  j = upper_bound(fEtaEdges.begin(), fEtaEdges.end(), eta) - fEtaEdges.begin();
+
+  // points on the edges depend on the comparison operators
+  if((i > 0 && fPTEdges[i - 1] == pt) || (j > 0 && fEtaEdges[j - 1] == eta)) return nan;
+
+  return fValues[j * (fPTEdges.size() + 1) + i];
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesFormulaGrid::Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy, Candidate *candidate) const
+{
+  Double_t value = FindValue(pt, eta);
+  return value == value ? value : fFormula->Eval(pt, eta, phi, energy, candidate);
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesFormulaGrid::Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy, Candidate *candidate, Double_t density) const
+{
+  Double_t value = FindValue(pt, eta);
+  return value == value ? value : fFormula->Eval(pt, eta, phi, energy, candidate, density);
+}
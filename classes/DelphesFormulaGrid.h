@@ -0,0 +1,77 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesFormulaGrid_h
+#define DelphesFormulaGrid_h
+
+/** \class DelphesFormulaGrid
+ *
+ *  Piecewise-constant (pt, eta) grid of a DelphesFormula.
+ *
+ *  The cell edges are the constants compared with pt, eta or abs(eta)
+ *  in the expression. The grid is only used when pt and eta appear
+ *  in no other place, so that the formula is constant in each cell.
+ *  The formula is evaluated on the cell edges, in the cells where
+ *  it is not finite, and for all other expressions.
+ *
+ */
+
+#include "Rtypes.h"
+
+#include <vector>
+
+class Candidate;
+class DelphesFormula;
+
+class DelphesFormulaGrid
+{
+public:
+  DelphesFormulaGrid();
+  ~DelphesFormulaGrid();
+
+  // the formula must be compiled from expression, it is not owned by the grid
+  void Build(DelphesFormula *formula, const char *expression);
+
+  Double_t Eval(Double_t pt, Double_t eta, Double_t phi = 0, Double_t energy = 0, Candidate *candidate = 0) const;
+
+  // density given instead of taken from the candidate
+  Double_t Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy, Candidate *candidate, Double_t density) const;
+
+  Int_t GetNumberOfCells() const { return fValues.size(); }
+  Int_t GetNumberOfConstantCells() const { return fNumberOfConstantCells; }
+
+private:
+  Bool_t FindEdges(const char *expression);
+
+  // value of the cell, NaN if the formula has to be evaluated
+  Double_t FindValue(Double_t pt, Double_t eta) const;
+
+  void SamplePoints(const std::vector<Double_t> &edges, Int_t cell, std::vector<Double_t> &points) const;
+
+  DelphesFormula *fFormula;
+
+  std::vector<Double_t> fPTEdges;
+  std::vector<Double_t> fEtaEdges;
+
+  // value of cell (eta cell) * (number of PT edges + 1) + PT cell, NaN if not finite
+  std::vector<Double_t> fValues;
+
+  Int_t fNumberOfConstantCells;
+};
+
+#endif /* DelphesFormulaGrid_h */
@@ -0,0 +1,546 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesHepMC3RootReader
+ *
+ *  Reads HepMC3 ROOT tree file (hepmc3_tree written by WriterRootTree)
+ *  without the HepMC3 library, from the split GenEventData arrays
+ *
+ */
+
+#include "classes/DelphesHepMC3RootReader.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "TBranch.h"
+#include "TDatabasePDG.h"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TLorentzVector.h"
+#include "TMath.h"
+#include "TObjArray.h"
+#include "TParticlePDG.h"
+#include "TStopwatch.h"
+#include "TTree.h"
+
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+#include "classes/DelphesStream.h"
+
+#include "ExRootAnalysis/ExRootTreeBranch.h"
+
+using namespace std;
+
+static const char *kTreeName = "hepmc3_tree";
+static const char *kEventBranchName = "hepmc3_event";
+
+//---------------------------------------------------------------------------
+
+DelphesHepMC3RootReader::DelphesHepMC3RootReader() :
+  fFile(0), fTree(0), fParticlesBranch(0), fVerticesBranch(0), fPDG(0),
+  fEventNumber(0), fMomentumUnit(1), fLengthUnit(0),
+  fNumberOfParticles(0), fNumberOfVertices(0),
+  fParticleCapacity(0), fVertexCapacity(0),
+  fMomentumCoefficient(1.0), fPositionCoefficient(1.0)
+{
+  fPDG = TDatabasePDG::Instance();
+}
+
+//---------------------------------------------------------------------------
+
+DelphesHepMC3RootReader::~DelphesHepMC3RootReader()
+{
+  Close();
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::Open(const char *fileName)
+{
+  stringstream message;
+
+  Close();
+
+  // keep the current directory, so that the output tree
+  // is not attached to the input file
+  TDirectory::TContext context;
+
+  fFile = TFile::Open(fileName);
+
+  if(fFile == 0 || fFile->IsZombie())
+  {
+    message << "can't open " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  fTree = static_cast<TTree *>(fFile->Get(kTreeName));
+
+  if(fTree == 0)
+  {
+    message << "can't find tree " << kTreeName << " in " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  // read the split GenEventData members as plain arrays, no dictionary needed
+  fTree->SetMakeClass(1);
+
+  fParticleCapacity = 0;
+  fVertexCapacity = 0;
+
+  fTree->SetBranchAddress(GetBranchName("event_number"), &fEventNumber);
+  fTree->SetBranchAddress(GetBranchName("momentum_unit"), &fMomentumUnit);
+  fTree->SetBranchAddress(GetBranchName("length_unit"), &fLengthUnit);
+
+  fTree->SetBranchAddress(GetBranchName("particles"), &fNumberOfParticles);
+  fTree->SetBranchAddress(GetBranchName("vertices"), &fNumberOfVertices);
+
+  fTree->SetBranchAddress(GetBranchName("weights"), &fWeights);
+  fTree->SetBranchAddress(GetBranchName("links1"), &fLinks1);
+  fTree->SetBranchAddress(GetBranchName("links2"), &fLinks2);
+
+  fParticlesBranch = fTree->GetBranch(GetBranchName("particles"));
+  fVerticesBranch = fTree->GetBranch(GetBranchName("vertices"));
+
+  if(FindBranch("attribute_id"))
+  {
+    fTree->SetBranchAddress(GetBranchName("attribute_id"), &fAttributeID);
+    fTree->SetBranchAddress(GetBranchName("attribute_name"), &fAttributeName);
+    fTree->SetBranchAddress(GetBranchName("attribute_string"), &fAttributeString);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::Close()
+{
+  if(fFile) delete fFile;
+  fFile = 0;
+  fTree = 0;
+  fParticlesBranch = 0;
+  fVerticesBranch = 0;
+}
+
+//---------------------------------------------------------------------------
+
+Long64_t DelphesHepMC3RootReader::GetEntries() const
+{
+  return fTree ? fTree->GetEntries() : 0;
+}
+
+//---------------------------------------------------------------------------
+
+TBranch *DelphesHepMC3RootReader::FindBranch(const char *member)
+{
+  TBranch *branch;
+
+  // split sub-branches may or may not carry the top-level branch name
+  fBranchName = kEventBranchName;
+  fBranchName += ".";
+  fBranchName += member;
+  branch = fTree->GetBranch(fBranchName.c_str());
+  if(branch) return branch;
+
+  fBranchName = member;
+  return fTree->GetBranch(fBranchName.c_str());
+}
+
+//---------------------------------------------------------------------------
+
+const char *DelphesHepMC3RootReader::GetBranchName(const char *member)
+{
+  stringstream message;
+
+  if(!FindBranch(member))
+  {
+    message << "can't find branch " << member << " in tree " << kTreeName;
+    throw runtime_error(message.str());
+  }
+
+  return fBranchName.c_str();
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::SetArrayAddresses()
+{
+  if(fNumberOfParticles > fParticleCapacity)
+  {
+    fParticleCapacity = fNumberOfParticles;
+
+    fPID.resize(fParticleCapacity);
+    fStatus.resize(fParticleCapacity);
+    fIsMassSet.resize(fParticleCapacity);
+    fMass.resize(fParticleCapacity);
+    fPx.resize(fParticleCapacity);
+    fPy.resize(fParticleCapacity);
+    fPz.resize(fParticleCapacity);
+    fE.resize(fParticleCapacity);
+
+    fTree->SetBranchAddress(GetBranchName("particles.pid"), &fPID[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.status"), &fStatus[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.is_mass_set"), &fIsMassSet[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.mass"), &fMass[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.momentum.m_v1"), &fPx[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.momentum.m_v2"), &fPy[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.momentum.m_v3"), &fPz[0]);
+    fTree->SetBranchAddress(GetBranchName("particles.momentum.m_v4"), &fE[0]);
+  }
+
+  if(fNumberOfVertices > fVertexCapacity)
+  {
+    fVertexCapacity = fNumberOfVertices;
+
+    fVertexStatus.resize(fVertexCapacity);
+    fX.resize(fVertexCapacity);
+    fY.resize(fVertexCapacity);
+    fZ.resize(fVertexCapacity);
+    fT.resize(fVertexCapacity);
+
+    fTree->SetBranchAddress(GetBranchName("vertices.status"), &fVertexStatus[0]);
+    fTree->SetBranchAddress(GetBranchName("vertices.position.m_v1"), &fX[0]);
+    fTree->SetBranchAddress(GetBranchName("vertices.position.m_v2"), &fY[0]);
+    fTree->SetBranchAddress(GetBranchName("vertices.position.m_v3"), &fZ[0]);
+    fTree->SetBranchAddress(GetBranchName("vertices.position.m_v4"), &fT[0]);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+bool DelphesHepMC3RootReader::ReadEntry(Long64_t entry, DelphesFactory *factory,
+  TObjArray *allParticleOutputArray,
+  TObjArray *stableParticleOutputArray,
+  TObjArray *partonOutputArray)
+{
+  if(!fTree || entry < 0 || entry >= fTree->GetEntries()) return kFALSE;
+
+  // read the collection sizes first to grow the arrays before the full entry
+  fParticlesBranch->GetEntry(entry);
+  fVerticesBranch->GetEntry(entry);
+
+  SetArrayAddresses();
+
+  if(fTree->GetEntry(entry) <= 0) return kFALSE;
+
+  fMomentumCoefficient = (fMomentumUnit == 0) ? 0.001 : 1.0;
+  fPositionCoefficient = (fLengthUnit == 1) ? 10.0 : 1.0;
+
+  AnalyzeAttributes();
+
+  AnalyzeParticles(factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray);
+
+  return kTRUE;
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::AnalyzeAttributes()
+{
+  size_t i;
+
+  fMPI = -1;
+  fProcessID = 0;
+  fScale = 0.0;
+  fAlphaQCD = 0.0;
+  fAlphaQED = 0.0;
+
+  fCrossSection = 0.0;
+  fCrossSectionError = 0.0;
+
+  fID1 = 0;
+  fID2 = 0;
+  fX1 = 0.0;
+  fX2 = 0.0;
+  fScalePDF = 0.0;
+  fPDF1 = 0.0;
+  fPDF2 = 0.0;
+
+  for(i = 0; i < fAttributeName.size() && i < fAttributeString.size(); ++i)
+  {
+    if(i < fAttributeID.size() && fAttributeID[i] != 0) continue;
+
+    const string &name = fAttributeName[i];
+    DelphesStream bufferStream(const_cast<char *>(fAttributeString[i].c_str()));
+
+    if(name == "mpi")
+    {
+      bufferStream.ReadInt(fMPI);
+    }
+    else if(name == "signal_process_id")
+    {
+      bufferStream.ReadInt(fProcessID);
+    }
+    else if(name == "event_scale")
+    {
+      bufferStream.ReadDbl(fScale);
+    }
+    else if(name == "alphaQCD")
+    {
+      bufferStream.ReadDbl(fAlphaQCD);
+    }
+    else if(name == "alphaQED")
+    {
+      bufferStream.ReadDbl(fAlphaQED);
+    }
+    else if(name == "GenCrossSection")
+    {
+      bufferStream.ReadDbl(fCrossSection)
+        && bufferStream.ReadDbl(fCrossSectionError);
+    }
+    else if(name == "GenPdfInfo")
+    {
+      bufferStream.ReadInt(fID1)
+        && bufferStream.ReadInt(fID2)
+        && bufferStream.ReadDbl(fX1)
+        && bufferStream.ReadDbl(fX2)
+        && bufferStream.ReadDbl(fScalePDF)
+        && bufferStream.ReadDbl(fPDF1)
+        && bufferStream.ReadDbl(fPDF2);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::AnalyzeParticles(DelphesFactory *factory,
+  TObjArray *allParticleOutputArray,
+  TObjArray *stableParticleOutputArray,
+  TObjArray *partonOutputArray)
+{
+  Candidate *candidate;
+  TParticlePDG *pdgParticle;
+  int pdgCode;
+  Int_t i, k, p, v, row, groups, first, last;
+  size_t j;
+  Double_t mass, x, y, z, t;
+
+  const Int_t n = fNumberOfParticles;
+  const Int_t m = fNumberOfVertices;
+
+  // particles have ids 1..n and vertices -1..-m, links relate both:
+  // (particle, -vertex) is incoming, (-vertex, particle) is outgoing
+
+  fProductionVertex.assign(n + 1, 0);
+  fEndVertex.assign(n + 1, 0);
+
+  for(j = 0; j < fLinks1.size() && j < fLinks2.size(); ++j)
+  {
+    if(fLinks1[j] > 0 && fLinks1[j] <= n && fLinks2[j] < 0 && -fLinks2[j] <= m)
+    {
+      fEndVertex[fLinks1[j]] = -fLinks2[j];
+    }
+    else if(fLinks1[j] < 0 && -fLinks1[j] <= m && fLinks2[j] > 0 && fLinks2[j] <= n)
+    {
+      fProductionVertex[fLinks2[j]] = -fLinks1[j];
+    }
+  }
+
+  // group particles by production vertex in order of first appearance,
+  // same output order as the ASCII reader
+
+  fVertexGroup.assign(m + 1, -1);
+  fGroupStart.assign(m + 2, 0);
+
+  groups = 0;
+  for(p = 1; p <= n; ++p)
+  {
+    v = fProductionVertex[p];
+    if(fVertexGroup[v] < 0) fVertexGroup[v] = groups++;
+    ++fGroupStart[fVertexGroup[v] + 1];
+  }
+
+  for(k = 0; k < groups; ++k)
+  {
+    fGroupStart[k + 1] += fGroupStart[k];
+  }
+
+  fGroupFill.assign(fGroupStart.begin(), fGroupStart.begin() + groups);
+  fRow.assign(n + 1, -1);
+  fOrder.assign(n, 0);
+
+  for(p = 1; p <= n; ++p)
+  {
+    row = fGroupFill[fVertexGroup[fProductionVertex[p]]]++;
+    fRow[p] = row;
+    fOrder[row] = p;
+  }
+
+  fMotherFirst.assign(m + 1, -1);
+  fMotherLast.assign(m + 1, -1);
+  fMotherCount.assign(m + 1, 0);
+
+  for(p = 1; p <= n; ++p)
+  {
+    v = fEndVertex[p];
+    if(v == 0) continue;
+
+    row = fRow[p];
+    if(fMotherCount[v] == 0 || row < fMotherFirst[v]) fMotherFirst[v] = row;
+    if(fMotherCount[v] == 0 || row > fMotherLast[v]) fMotherLast[v] = row;
+    ++fMotherCount[v];
+  }
+
+  for(row = 0; row < n; ++row)
+  {
+    p = fOrder[row];
+    i = p - 1;
+
+    candidate = factory->NewCandidate();
+
+    candidate->PID = fPID[i];
+
+    candidate->Status = fStatus[i];
+
+    mass = fMass[i];
+    if(!fIsMassSet[i])
+    {
+      mass = fE[i]*fE[i] - fPx[i]*fPx[i] - fPy[i]*fPy[i] - fPz[i]*fPz[i];
+      mass = mass > 0.0 ? TMath::Sqrt(mass) : -TMath::Sqrt(-mass);
+    }
+    candidate->Mass = mass;
+
+    candidate->Momentum.SetPxPyPzE(fPx[i], fPy[i], fPz[i], fE[i]);
+    if(fMomentumCoefficient != 1.0)
+    {
+      candidate->Momentum *= fMomentumCoefficient;
+    }
+
+    v = fProductionVertex[p];
+    if(v > 0)
+    {
+      candidate->Position.SetXYZT(fX[v - 1], fY[v - 1], fZ[v - 1], fT[v - 1]);
+    }
+    else
+    {
+      candidate->Position.SetXYZT(0.0, 0.0, 0.0, 0.0);
+    }
+    if(fPositionCoefficient != 1.0)
+    {
+      candidate->Position *= fPositionCoefficient;
+    }
+
+    if(v > 0 && fMotherCount[v] > 0)
+    {
+      candidate->M1 = fMotherFirst[v];
+      candidate->M2 = fMotherCount[v] > 1 ? fMotherLast[v] : -1;
+    }
+    else
+    {
+      candidate->M1 = -1;
+      candidate->M2 = -1;
+    }
+
+    v = fEndVertex[p];
+    if(v == 0)
+    {
+      candidate->D1 = -1;
+      candidate->D2 = -1;
+    }
+    else if(fVertexGroup[v] < 0)
+    {
+      candidate->D1 = -1;
+      candidate->D2 = -1;
+      candidate->DecayPosition = candidate->Position;
+    }
+    else
+    {
+      first = fGroupStart[fVertexGroup[v]];
+      last = fGroupStart[fVertexGroup[v] + 1] - 1;
+      candidate->D1 = first;
+      candidate->D2 = last;
+
+      x = fX[v - 1];
+      y = fY[v - 1];
+      z = fZ[v - 1];
+      t = fT[v - 1];
+      candidate->DecayPosition.SetXYZT(x, y, z, t);
+      if(fPositionCoefficient != 1.0)
+      {
+        candidate->DecayPosition *= fPositionCoefficient;
+      }
+    }
+
+    allParticleOutputArray->Add(candidate);
+
+    pdgParticle = fPDG->GetParticle(candidate->PID);
+
+    candidate->Charge = pdgParticle ? int(pdgParticle->Charge() / 3.0) : -999;
+
+    if(!pdgParticle) continue;
+
+    pdgCode = TMath::Abs(candidate->PID);
+
+    if(candidate->Status == 1)
+    {
+      stableParticleOutputArray->Add(candidate);
+    }
+    else if(pdgCode <= 5 || pdgCode == 21 || pdgCode == 15)
+    {
+      partonOutputArray->Add(candidate);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::AnalyzeEvent(ExRootTreeBranch *branch, long long /*eventNumber*/,
+  TStopwatch *readStopWatch, TStopwatch *procStopWatch)
+{
+  HepMCEvent *element;
+
+  element = static_cast<HepMCEvent *>(branch->NewEntry());
+  element->Number = fEventNumber;
+
+  element->ProcessID = fProcessID;
+  element->MPI = fMPI;
+  element->Weight = fWeights.size() > 0 ? fWeights[0] : 1.0;
+  element->CrossSection = fCrossSection;
+  element->CrossSectionError = fCrossSectionError;
+  element->Scale = fScale;
+  element->AlphaQED = fAlphaQED;
+  element->AlphaQCD = fAlphaQCD;
+
+  element->ID1 = fID1;
+  element->ID2 = fID2;
+  element->X1 = fX1;
+  element->X2 = fX2;
+  element->ScalePDF = fScalePDF;
+  element->PDF1 = fPDF1;
+  element->PDF2 = fPDF2;
+
+  element->ReadTime = readStopWatch->RealTime();
+  element->ProcTime = procStopWatch->RealTime();
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMC3RootReader::AnalyzeWeight(ExRootTreeBranch *branch)
+{
+  Weight *element;
+  vector<double>::const_iterator itWeights;
+
+  for(itWeights = fWeights.begin(); itWeights != fWeights.end(); ++itWeights)
+  {
+    element = static_cast<Weight *>(branch->NewEntry());
+
+    element->Weight = *itWeights;
+  }
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,117 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesHepMC3RootReader_h
+#define DelphesHepMC3RootReader_h
+
+/** \class DelphesHepMC3RootReader
+ *
+ *  Reads HepMC3 ROOT tree file (hepmc3_tree written by WriterRootTree)
+ *  without the HepMC3 library, from the split GenEventData arrays
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "Rtypes.h"
+
+class TFile;
+class TTree;
+class TBranch;
+class TObjArray;
+class TStopwatch;
+class TDatabasePDG;
+class ExRootTreeBranch;
+class DelphesFactory;
+
+class DelphesHepMC3RootReader
+{
+public:
+  DelphesHepMC3RootReader();
+  ~DelphesHepMC3RootReader();
+
+  void Open(const char *fileName);
+  void Close();
+
+  Long64_t GetEntries() const;
+
+  bool ReadEntry(Long64_t entry, DelphesFactory *factory,
+    TObjArray *allParticleOutputArray,
+    TObjArray *stableParticleOutputArray,
+    TObjArray *partonOutputArray);
+
+  void AnalyzeEvent(ExRootTreeBranch *branch, long long eventNumber,
+    TStopwatch *readStopWatch, TStopwatch *procStopWatch);
+
+  void AnalyzeWeight(ExRootTreeBranch *branch);
+
+private:
+  TBranch *FindBranch(const char *member);
+  const char *GetBranchName(const char *member);
+
+  void SetArrayAddresses();
+
+  void AnalyzeAttributes();
+
+  void AnalyzeParticles(DelphesFactory *factory,
+    TObjArray *allParticleOutputArray,
+    TObjArray *stableParticleOutputArray,
+    TObjArray *partonOutputArray);
+
+  TFile *fFile;
+  TTree *fTree;
+
+  TBranch *fParticlesBranch, *fVerticesBranch;
+
+  TDatabasePDG *fPDG;
+
+  std::string fBranchName;
+
+  Int_t fEventNumber, fMomentumUnit, fLengthUnit;
+  Int_t fNumberOfParticles, fNumberOfVertices;
+  Int_t fParticleCapacity, fVertexCapacity;
+
+  std::vector<Int_t> fPID, fStatus;
+  std::vector<Char_t> fIsMassSet;
+  std::vector<Double_t> fMass, fPx, fPy, fPz, fE;
+
+  std::vector<Int_t> fVertexStatus;
+  std::vector<Double_t> fX, fY, fZ, fT;
+
+  std::vector<Double_t> fWeights;
+  std::vector<Int_t> fLinks1, fLinks2;
+  std::vector<Int_t> fAttributeID;
+  std::vector<std::string> fAttributeName, fAttributeString;
+
+  std::vector<Int_t> fProductionVertex, fEndVertex, fVertexGroup;
+  std::vector<Int_t> fGroupStart, fGroupFill, fRow, fOrder;
+  std::vector<Int_t> fMotherFirst, fMotherLast, fMotherCount;
+
+  int fMPI, fProcessID;
+  double fScale, fAlphaQCD, fAlphaQED;
+
+  double fCrossSection, fCrossSectionError;
+
+  int fID1, fID2;
+  double fX1, fX2, fScalePDF, fPDF1, fPDF2;
+
+  double fMomentumCoefficient, fPositionCoefficient;
+};
+
+#endif // DelphesHepMC3RootReader_h
@@ -30,6 +30,7 @@
 
 #include "ExRootAnalysis/ExRootResult.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
 #include "ExRootAnalysis/ExRootTreeReader.h"
 #include "ExRootAnalysis/ExRootTreeWriter.h"
 
@@ -89,6 +90,8 @@ TObjArray *DelphesModule::ImportArray(const char *name)
     throw runtime_error(message.str());
   }
 
+  fImportedArrays.push_back(name);
+
   return object;
 }
 
@@ -129,6 +132,23 @@ ExRootTreeBranch *DelphesModule::NewBranch(const char *name, TClass *cl)
 
 //------------------------------------------------------------------------------
 
+ExRootTreeFlatBranch *DelphesModule::NewFlatBranch(const char *name)
+{
+  stringstream message;
+  if(!fTreeWriter)
+  {
+    fTreeWriter = static_cast<ExRootTreeWriter *>(GetObject("TreeWriter", ExRootTreeWriter::Class()));
+    if(!fTreeWriter)
+    {
+      message << "can't access access tree writer";
+      throw runtime_error(message.str());
+    }
+  }
+  return fTreeWriter->NewFlatBranch(name);
+}
+
+//------------------------------------------------------------------------------
+
 void DelphesModule::AddInfo(const char *name, Double_t value)
 {
   stringstream message;
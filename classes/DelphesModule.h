@@ -29,6 +29,10 @@
 
 #include "ExRootAnalysis/ExRootTask.h"
 
+#include "TString.h"
+
+#include <vector>
+
 class TClass;
 class TObject;
 class TFolder;
@@ -36,6 +40,7 @@ class TClonesArray;
 
 class ExRootResult;
 class ExRootTreeBranch;
+class ExRootTreeFlatBranch;
 class ExRootTreeWriter;
 
 class DelphesFactory;
@@ -54,11 +59,24 @@ public:
   TObjArray *ExportArray(const char *name);
 
   ExRootTreeBranch *NewBranch(const char *name, TClass *cl);
+  ExRootTreeFlatBranch *NewFlatBranch(const char *name);
   void AddInfo(const char *name, Double_t value);
 
   ExRootResult *GetPlots();
   DelphesFactory *GetFactory();
 
+  // arrays imported and exported by this module, used by Delphes
+  // to find the modules whose outputs are never consumed
+  const std::vector<TString> &GetImportedArrays() const { return fImportedArrays; }
+  TFolder *GetExportFolder() const { return fExportFolder; }
+
+  // true if the module writes to the output tree or fills plots
+  Bool_t HasOutput() const { return fTreeWriter || fPlots; }
+
+  // a module returning true stops the execution path for the current event,
+  // and the event is not written
+  virtual Bool_t IsEventRejected() const { return kFALSE; }
+
 protected:
   ExRootTreeWriter *fTreeWriter;
   DelphesFactory *fFactory;
@@ -68,6 +86,8 @@ private:
 
   TFolder *fPlotFolder, *fExportFolder;
 
+  std::vector<TString> fImportedArrays; //!
+
   ClassDef(DelphesModule, 1)
 };
 
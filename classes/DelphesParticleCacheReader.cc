@@ -0,0 +1,259 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesParticleCacheReader
+ *
+ *  Reads generator-level particle cache binary file
+ *
+ */
+
+#include "classes/DelphesParticleCacheReader.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "TObjArray.h"
+#include "TStopwatch.h"
+
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+#include "classes/DelphesXDRReader.h"
+
+#include "ExRootAnalysis/ExRootTreeBranch.h"
+
+using namespace std;
+
+static const int kHeaderSize = 15 * 4;
+static const int kWeightSize = 2 * 4;
+static const int kParticleSize = 8 * 4 + 13 * 8;
+
+static const int32_t kStable = 1;
+static const int32_t kParton = 2;
+
+//------------------------------------------------------------------------------
+
+DelphesParticleCacheReader::DelphesParticleCacheReader(const char *fileName) :
+  fEntries(0), fNumberOfWeights(0), fNumberOfParticles(0),
+  fProcessID(0), fMPI(0), fID1(0), fID2(0),
+  fWeight(0), fCrossSection(0), fCrossSectionError(0),
+  fScale(0), fAlphaQED(0), fAlphaQCD(0),
+  fX1(0), fX2(0), fScalePDF(0), fPDF1(0), fPDF2(0),
+  fCacheFile(0), fInputReader(0), fBufferReader(0)
+{
+  stringstream message;
+  int64_t i;
+
+  fInputReader = new DelphesXDRReader;
+  fBufferReader = new DelphesXDRReader;
+
+  fCacheFile = fopen(fileName, "rb");
+
+  if(fCacheFile == NULL)
+  {
+    message << "can't open particle cache file " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  fInputReader->SetFile(fCacheFile);
+
+  // read number of events
+  fseeko(fCacheFile, -8, SEEK_END);
+  fInputReader->ReadValue(&fEntries, 8);
+
+  if(fEntries < 0 || ftello(fCacheFile) < 8 + 8 * fEntries)
+  {
+    message << "corrupted particle cache file " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  // read index of events
+  fIndex.resize(fEntries);
+  fseeko(fCacheFile, -8 - 8 * fEntries, SEEK_END);
+  for(i = 0; i < fEntries; ++i)
+  {
+    fInputReader->ReadValue(&fIndex[i], 8);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+DelphesParticleCacheReader::~DelphesParticleCacheReader()
+{
+  if(fCacheFile) fclose(fCacheFile);
+  if(fBufferReader) delete fBufferReader;
+  if(fInputReader) delete fInputReader;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesParticleCacheReader::ReadEntry(int64_t entry)
+{
+  int32_t size;
+
+  if(entry < 0 || entry >= fEntries) return false;
+
+  // read event
+  fseeko(fCacheFile, fIndex[entry], SEEK_SET);
+  fInputReader->ReadValue(&size, 4);
+
+  if(size < kHeaderSize + 8)
+  {
+    throw runtime_error("corrupted event in particle cache file");
+  }
+
+  fBuffer.resize(size);
+  fInputReader->ReadRaw(&fBuffer[0], size);
+
+  fBufferReader->SetBuffer(&fBuffer[0]);
+
+  fBufferReader->ReadValue(&fProcessID, 4);
+  fBufferReader->ReadValue(&fMPI, 4);
+  fBufferReader->ReadValue(&fID1, 4);
+  fBufferReader->ReadValue(&fID2, 4);
+
+  fBufferReader->ReadValue(&fWeight, 4);
+  fBufferReader->ReadValue(&fCrossSection, 4);
+  fBufferReader->ReadValue(&fCrossSectionError, 4);
+  fBufferReader->ReadValue(&fScale, 4);
+  fBufferReader->ReadValue(&fAlphaQED, 4);
+  fBufferReader->ReadValue(&fAlphaQCD, 4);
+  fBufferReader->ReadValue(&fX1, 4);
+  fBufferReader->ReadValue(&fX2, 4);
+  fBufferReader->ReadValue(&fScalePDF, 4);
+  fBufferReader->ReadValue(&fPDF1, 4);
+  fBufferReader->ReadValue(&fPDF2, 4);
+
+  fBufferReader->ReadValue(&fNumberOfWeights, 4);
+  fBufferReader->ReadValue(&fNumberOfParticles, 4);
+
+  if(size != kHeaderSize + 8 + fNumberOfWeights * kWeightSize + fNumberOfParticles * kParticleSize)
+  {
+    throw runtime_error("corrupted event in particle cache file");
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheReader::ReadParticles(DelphesFactory *factory,
+  TObjArray *allParticleOutputArray,
+  TObjArray *stableParticleOutputArray,
+  TObjArray *partonOutputArray)
+{
+  Candidate *candidate;
+  Int_t i, j;
+  int32_t pid, status, charge, flags, m1, m2, d1, d2;
+  double data[13];
+
+  fBufferReader->SetOffset(kHeaderSize + 8 + fNumberOfWeights * kWeightSize);
+
+  for(i = 0; i < fNumberOfParticles; ++i)
+  {
+    fBufferReader->ReadValue(&pid, 4);
+    fBufferReader->ReadValue(&status, 4);
+    fBufferReader->ReadValue(&charge, 4);
+    fBufferReader->ReadValue(&flags, 4);
+    fBufferReader->ReadValue(&m1, 4);
+    fBufferReader->ReadValue(&m2, 4);
+    fBufferReader->ReadValue(&d1, 4);
+    fBufferReader->ReadValue(&d2, 4);
+
+    for(j = 0; j < 13; ++j) fBufferReader->ReadValue(&data[j], 8);
+
+    candidate = factory->NewCandidate();
+
+    candidate->PID = pid;
+    candidate->Status = status;
+    candidate->Charge = charge;
+
+    candidate->M1 = m1;
+    candidate->M2 = m2;
+    candidate->D1 = d1;
+    candidate->D2 = d2;
+
+    candidate->Mass = data[0];
+
+    candidate->Momentum.SetPxPyPzE(data[1], data[2], data[3], data[4]);
+    candidate->Position.SetXYZT(data[5], data[6], data[7], data[8]);
+    candidate->DecayPosition.SetXYZT(data[9], data[10], data[11], data[12]);
+
+    allParticleOutputArray->Add(candidate);
+
+    if(flags & kStable) stableParticleOutputArray->Add(candidate);
+    if(flags & kParton) partonOutputArray->Add(candidate);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheReader::AnalyzeEvent(ExRootTreeBranch *branch, long long eventNumber,
+  TStopwatch *readStopWatch, TStopwatch *procStopWatch)
+{
+  HepMCEvent *element;
+
+  element = static_cast<HepMCEvent *>(branch->NewEntry());
+  element->Number = eventNumber;
+
+  element->ProcessID = fProcessID;
+  element->MPI = fMPI;
+  element->Weight = fWeight;
+  element->CrossSection = fCrossSection;
+  element->CrossSectionError = fCrossSectionError;
+  element->Scale = fScale;
+  element->AlphaQED = fAlphaQED;
+  element->AlphaQCD = fAlphaQCD;
+
+  element->ID1 = fID1;
+  element->ID2 = fID2;
+  element->X1 = fX1;
+  element->X2 = fX2;
+  element->ScalePDF = fScalePDF;
+  element->PDF1 = fPDF1;
+  element->PDF2 = fPDF2;
+
+  element->ReadTime = readStopWatch->RealTime();
+  element->ProcTime = procStopWatch->RealTime();
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheReader::AnalyzeWeight(ExRootTreeBranch *branch)
+{
+  Weight *element;
+  Int_t i;
+  int32_t id;
+  float weight;
+
+  fBufferReader->SetOffset(kHeaderSize + 8);
+
+  for(i = 0; i < fNumberOfWeights; ++i)
+  {
+    fBufferReader->ReadValue(&id, 4);
+    fBufferReader->ReadValue(&weight, 4);
+
+    element = static_cast<Weight *>(branch->NewEntry());
+    element->Weight = weight;
+  }
+}
+
+//------------------------------------------------------------------------------
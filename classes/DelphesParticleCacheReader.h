@@ -0,0 +1,80 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesParticleCacheReader_h
+#define DelphesParticleCacheReader_h
+
+/** \class DelphesParticleCacheReader
+ *
+ *  Reads generator-level particle cache binary file
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+class TObjArray;
+class TStopwatch;
+class ExRootTreeBranch;
+class DelphesFactory;
+class DelphesXDRReader;
+
+class DelphesParticleCacheReader
+{
+public:
+  DelphesParticleCacheReader(const char *fileName);
+
+  ~DelphesParticleCacheReader();
+
+  bool ReadEntry(int64_t entry);
+
+  void ReadParticles(DelphesFactory *factory,
+    TObjArray *allParticleOutputArray,
+    TObjArray *stableParticleOutputArray,
+    TObjArray *partonOutputArray);
+
+  void AnalyzeEvent(ExRootTreeBranch *branch, long long eventNumber,
+    TStopwatch *readStopWatch, TStopwatch *procStopWatch);
+
+  void AnalyzeWeight(ExRootTreeBranch *branch);
+
+  int64_t GetEntries() const { return fEntries; }
+
+private:
+  int64_t fEntries;
+
+  int32_t fNumberOfWeights;
+  int32_t fNumberOfParticles;
+
+  int32_t fProcessID, fMPI, fID1, fID2;
+  float fWeight, fCrossSection, fCrossSectionError;
+  float fScale, fAlphaQED, fAlphaQCD;
+  float fX1, fX2, fScalePDF, fPDF1, fPDF2;
+
+  FILE *fCacheFile;
+
+  std::vector<int64_t> fIndex;
+  std::vector<uint8_t> fBuffer;
+
+  DelphesXDRReader *fInputReader;
+  DelphesXDRReader *fBufferReader;
+};
+
+#endif // DelphesParticleCacheReader_h
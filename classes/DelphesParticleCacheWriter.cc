@@ -0,0 +1,299 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class DelphesParticleCacheWriter
+ *
+ *  Writes generator-level particle cache binary file
+ *
+ */
+
+#include "classes/DelphesParticleCacheWriter.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "TObjArray.h"
+
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesXDRWriter.h"
+
+using namespace std;
+
+// event record: ProcessID, MPI, ID1, ID2, Weight, CrossSection,
+// CrossSectionError, Scale, AlphaQED, AlphaQCD, X1, X2, ScalePDF, PDF1, PDF2
+static const int kHeaderSize = 15 * 4;
+// weight record: ID, Weight
+static const int kWeightSize = 2 * 4;
+// particle record: PID, Status, Charge, Flags, M1, M2, D1, D2,
+// Mass, Momentum, Position, DecayPosition
+static const int kParticleSize = 8 * 4 + 13 * 8;
+
+static const int32_t kStable = 1;
+static const int32_t kParton = 2;
+
+//------------------------------------------------------------------------------
+
+DelphesParticleCacheWriter::DelphesParticleCacheWriter(const char *fileName) :
+  fNumberOfWeights(0), fNumberOfParticles(0), fOffset(0),
+  fCacheFile(0), fOutputWriter(0), fBufferWriter(0)
+{
+  stringstream message;
+
+  fHeader.resize(kHeaderSize, 0);
+
+  fOutputWriter = new DelphesXDRWriter;
+  fBufferWriter = new DelphesXDRWriter;
+
+  fCacheFile = fopen(fileName, "wb");
+
+  if(fCacheFile == NULL)
+  {
+    message << "can't open particle cache file " << fileName;
+    throw runtime_error(message.str());
+  }
+
+  fOutputWriter->SetFile(fCacheFile);
+}
+
+//------------------------------------------------------------------------------
+
+DelphesParticleCacheWriter::~DelphesParticleCacheWriter()
+{
+  if(fCacheFile) fclose(fCacheFile);
+  if(fBufferWriter) delete fBufferWriter;
+  if(fOutputWriter) delete fOutputWriter;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheWriter::WriteParticles(TObjArray *allParticleArray,
+  TObjArray *stableParticleArray,
+  TObjArray *partonArray)
+{
+  Candidate *candidate;
+  Int_t i, j, stable, parton;
+  int32_t value, flags;
+  double data[13];
+
+  fNumberOfParticles = allParticleArray->GetEntriesFast();
+  fParticles.resize(fNumberOfParticles * kParticleSize);
+
+  if(fNumberOfParticles == 0) return;
+
+  fBufferWriter->SetBuffer(&fParticles[0]);
+
+  // the readers add stable particles and partons in the same order
+  // as all particles, so that the membership is found in a single pass
+  stable = 0;
+  parton = 0;
+  for(i = 0; i < fNumberOfParticles; ++i)
+  {
+    candidate = static_cast<Candidate *>(allParticleArray->At(i));
+
+    flags = 0;
+    if(stable < stableParticleArray->GetEntriesFast() && stableParticleArray->At(stable) == candidate)
+    {
+      flags |= kStable;
+      ++stable;
+    }
+    if(parton < partonArray->GetEntriesFast() && partonArray->At(parton) == candidate)
+    {
+      flags |= kParton;
+      ++parton;
+    }
+
+    value = candidate->PID;
+    fBufferWriter->WriteValue(&value, 4);
+    value = candidate->Status;
+    fBufferWriter->WriteValue(&value, 4);
+    value = candidate->Charge;
+    fBufferWriter->WriteValue(&value, 4);
+    fBufferWriter->WriteValue(&flags, 4);
+    value = candidate->M1;
+    fBufferWriter->WriteValue(&value, 4);
+    value = candidate->M2;
+    fBufferWriter->WriteValue(&value, 4);
+    value = candidate->D1;
+    fBufferWriter->WriteValue(&value, 4);
+    value = candidate->D2;
+    fBufferWriter->WriteValue(&value, 4);
+
+    data[0] = candidate->Mass;
+
+    data[1] = candidate->Momentum.Px();
+    data[2] = candidate->Momentum.Py();
+    data[3] = candidate->Momentum.Pz();
+    data[4] = candidate->Momentum.E();
+
+    data[5] = candidate->Position.X();
+    data[6] = candidate->Position.Y();
+    data[7] = candidate->Position.Z();
+    data[8] = candidate->Position.T();
+
+    data[9] = candidate->DecayPosition.X();
+    data[10] = candidate->DecayPosition.Y();
+    data[11] = candidate->DecayPosition.Z();
+    data[12] = candidate->DecayPosition.T();
+
+    for(j = 0; j < 13; ++j) fBufferWriter->WriteValue(&data[j], 8);
+  }
+
+  if(stable != stableParticleArray->GetEntriesFast() || parton != partonArray->GetEntriesFast())
+  {
+    throw runtime_error("stable particles and partons are not ordered as all particles");
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheWriter::WriteEvent(const HepMCEvent *event)
+{
+  int32_t value;
+  float number;
+
+  fBufferWriter->SetBuffer(&fHeader[0]);
+
+  value = event->ProcessID;
+  fBufferWriter->WriteValue(&value, 4);
+  value = event->MPI;
+  fBufferWriter->WriteValue(&value, 4);
+  value = event->ID1;
+  fBufferWriter->WriteValue(&value, 4);
+  value = event->ID2;
+  fBufferWriter->WriteValue(&value, 4);
+
+  number = event->Weight;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->CrossSection;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->CrossSectionError;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->Scale;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->AlphaQED;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->AlphaQCD;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->X1;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->X2;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->ScalePDF;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->PDF1;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->PDF2;
+  fBufferWriter->WriteValue(&number, 4);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheWriter::WriteEvent(const LHEFEvent *event)
+{
+  int32_t value;
+  float number;
+
+  fBufferWriter->SetBuffer(&fHeader[0]);
+
+  value = event->ProcessID;
+  fBufferWriter->WriteValue(&value, 4);
+  value = 0;
+  fBufferWriter->WriteValue(&value, 4);
+  fBufferWriter->WriteValue(&value, 4);
+  fBufferWriter->WriteValue(&value, 4);
+
+  number = event->Weight;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->CrossSection;
+  fBufferWriter->WriteValue(&number, 4);
+  number = 0.0;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->ScalePDF;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->AlphaQED;
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->AlphaQCD;
+  fBufferWriter->WriteValue(&number, 4);
+  number = 0.0;
+  fBufferWriter->WriteValue(&number, 4);
+  fBufferWriter->WriteValue(&number, 4);
+  number = event->ScalePDF;
+  fBufferWriter->WriteValue(&number, 4);
+  number = 0.0;
+  fBufferWriter->WriteValue(&number, 4);
+  fBufferWriter->WriteValue(&number, 4);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheWriter::WriteWeight(int32_t id, float weight)
+{
+  fWeights.resize((fNumberOfWeights + 1) * kWeightSize);
+
+  fBufferWriter->SetBuffer(&fWeights[0]);
+  fBufferWriter->SetOffset(fNumberOfWeights * kWeightSize);
+
+  fBufferWriter->WriteValue(&id, 4);
+  fBufferWriter->WriteValue(&weight, 4);
+
+  ++fNumberOfWeights;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheWriter::WriteEntry()
+{
+  int32_t size;
+
+  size = kHeaderSize + 8 + fNumberOfWeights * kWeightSize + fNumberOfParticles * kParticleSize;
+
+  fOutputWriter->WriteValue(&size, 4);
+  fOutputWriter->WriteRaw(&fHeader[0], kHeaderSize);
+  fOutputWriter->WriteValue(&fNumberOfWeights, 4);
+  fOutputWriter->WriteValue(&fNumberOfParticles, 4);
+  if(fNumberOfWeights > 0) fOutputWriter->WriteRaw(&fWeights[0], fNumberOfWeights * kWeightSize);
+  if(fNumberOfParticles > 0) fOutputWriter->WriteRaw(&fParticles[0], fNumberOfParticles * kParticleSize);
+
+  fIndex.push_back(fOffset);
+  fOffset += size + 4;
+
+  fNumberOfWeights = 0;
+  fNumberOfParticles = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesParticleCacheWriter::WriteIndex()
+{
+  int64_t entries;
+  vector<int64_t>::iterator itIndex;
+
+  for(itIndex = fIndex.begin(); itIndex != fIndex.end(); ++itIndex)
+  {
+    fOutputWriter->WriteValue(&(*itIndex), 8);
+  }
+
+  entries = fIndex.size();
+  fOutputWriter->WriteValue(&entries, 8);
+}
+
+//------------------------------------------------------------------------------
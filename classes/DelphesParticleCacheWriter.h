@@ -0,0 +1,74 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesParticleCacheWriter_h
+#define DelphesParticleCacheWriter_h
+
+/** \class DelphesParticleCacheWriter
+ *
+ *  Writes generator-level particle cache binary file
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+class TObjArray;
+class HepMCEvent;
+class LHEFEvent;
+class DelphesXDRWriter;
+
+class DelphesParticleCacheWriter
+{
+public:
+  DelphesParticleCacheWriter(const char *fileName);
+
+  ~DelphesParticleCacheWriter();
+
+  void WriteParticles(TObjArray *allParticleArray,
+    TObjArray *stableParticleArray,
+    TObjArray *partonArray);
+
+  void WriteEvent(const HepMCEvent *event);
+  void WriteEvent(const LHEFEvent *event);
+
+  void WriteWeight(int32_t id, float weight);
+
+  void WriteEntry();
+
+  void WriteIndex();
+
+private:
+  int32_t fNumberOfWeights;
+  int32_t fNumberOfParticles;
+  int64_t fOffset;
+
+  FILE *fCacheFile;
+
+  std::vector<int64_t> fIndex;
+  std::vector<uint8_t> fHeader;
+  std::vector<uint8_t> fWeights;
+  std::vector<uint8_t> fParticles;
+
+  DelphesXDRWriter *fOutputWriter;
+  DelphesXDRWriter *fBufferWriter;
+};
+
+#endif // DelphesParticleCacheWriter_h
@@ -0,0 +1,477 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Resamples the pseudo b-tag scores of the PseudoBTagScore module
+for an existing Delphes output file, without rerunning the simulation.
+
+Only the PT, Eta and Flavor leaves of the jet branch are read. The scores
+are computed in batches of events by several threads, with the same
+histograms and bins as the module, and written to the <branch>_btagDeepFlavB
+leaf of a friend tree, e.g.
+
+  Delphes->AddFriend("BTagScore", "scores.root");
+  Delphes->Draw("BTagScore.Jet_btagDeepFlavB");
+
+The uniform number of each jet is a hash of the seed and of the jet index
+in the file, so the scores do not depend on the number of threads
+or on the batch size.
+*/
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <stdlib.h>
+
+#include "TApplication.h"
+#include "TROOT.h"
+
+#include "TBranch.h"
+#include "TFile.h"
+#include "TTree.h"
+
+#include "classes/DelphesBTagScoreSampler.h"
+
+#include "ExRootAnalysis/ExRootConfReader.h"
+#include "ExRootAnalysis/ExRootProgressBar.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+struct TJetBatch
+{
+  Long64_t firstEntry, firstJet;
+  vector<Int_t> size;
+  vector<Float_t> pt, eta;
+  vector<UInt_t> flavor;
+  vector<Double_t> u;
+  vector<Float_t> score;
+};
+
+//---------------------------------------------------------------------------
+
+class JetReader
+{
+public:
+  JetReader(TTree *tree, const char *jetBranchName);
+
+  Long64_t GetEntries() const { return fTree->GetEntries(); }
+
+  // append the jets of the next events to batch, returns the number of events read
+  Long64_t ReadBatch(Long64_t firstEntry, Long64_t maxEntries, TJetBatch &batch);
+
+private:
+  void SetArrayAddresses();
+
+  TTree *fTree;
+
+  TBranch *fBranchJet, *fBranchPT, *fBranchEta, *fBranchFlavor;
+
+  Int_t fSize, fCapacity;
+
+  vector<Float_t> fPT, fEta;
+  vector<UInt_t> fFlavor;
+};
+
+//---------------------------------------------------------------------------
+
+JetReader::JetReader(TTree *tree, const char *jetBranchName) :
+  fTree(tree), fSize(0), fCapacity(0)
+{
+  stringstream message;
+  string name = jetBranchName;
+
+  // read the split jet members as plain arrays, no dictionary needed
+  fTree->SetMakeClass(1);
+  fTree->SetBranchStatus("*", 0);
+
+  fBranchJet = fTree->GetBranch(name.c_str());
+  fBranchPT = fTree->GetBranch((name + ".PT").c_str());
+  fBranchEta = fTree->GetBranch((name + ".Eta").c_str());
+  fBranchFlavor = fTree->GetBranch((name + ".Flavor").c_str());
+
+  if(!fBranchJet || !fBranchPT || !fBranchEta || !fBranchFlavor)
+  {
+    message << "can't find branches " << name << ".PT, " << name << ".Eta and " << name << ".Flavor";
+    throw runtime_error(message.str());
+  }
+
+  fBranchJet->SetStatus(1);
+  fBranchPT->SetStatus(1);
+  fBranchEta->SetStatus(1);
+  fBranchFlavor->SetStatus(1);
+
+  fBranchJet->SetAddress(&fSize);
+}
+
+//---------------------------------------------------------------------------
+
+void JetReader::SetArrayAddresses()
+{
+  if(fSize <= fCapacity) return;
+
+  fCapacity = fSize;
+
+  fPT.resize(fCapacity);
+  fEta.resize(fCapacity);
+  fFlavor.resize(fCapacity);
+
+  fBranchPT->SetAddress(&fPT[0]);
+  fBranchEta->SetAddress(&fEta[0]);
+  fBranchFlavor->SetAddress(&fFlavor[0]);
+}
+
+//---------------------------------------------------------------------------
+
+Long64_t JetReader::ReadBatch(Long64_t firstEntry, Long64_t maxEntries, TJetBatch &batch)
+{
+  Long64_t entry, lastEntry;
+  stringstream message;
+
+  batch.firstEntry = firstEntry;
+  batch.size.clear();
+  batch.pt.clear();
+  batch.eta.clear();
+  batch.flavor.clear();
+
+  lastEntry = firstEntry + maxEntries;
+  if(lastEntry > GetEntries()) lastEntry = GetEntries();
+
+  for(entry = firstEntry; entry < lastEntry; ++entry)
+  {
+    // read the number of jets first to grow the arrays
+    if(fBranchJet->GetEntry(entry) <= 0)
+    {
+      message << "can't read event " << entry;
+      throw runtime_error(message.str());
+    }
+
+    SetArrayAddresses();
+
+    fBranchPT->GetEntry(entry);
+    fBranchEta->GetEntry(entry);
+    fBranchFlavor->GetEntry(entry);
+
+    batch.size.push_back(fSize);
+    batch.pt.insert(batch.pt.end(), fPT.begin(), fPT.begin() + fSize);
+    batch.eta.insert(batch.eta.end(), fEta.begin(), fEta.begin() + fSize);
+    batch.flavor.insert(batch.flavor.end(), fFlavor.begin(), fFlavor.begin() + fSize);
+  }
+
+  batch.u.resize(batch.pt.size());
+  batch.score.resize(batch.pt.size());
+
+  return lastEntry - firstEntry;
+}
+
+//---------------------------------------------------------------------------
+
+static Double_t Uniform(ULong64_t seed, ULong64_t index)
+{
+  // splitmix64 finalizer, uniform in (0, 1)
+  ULong64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  return ((z >> 11) + 0.5) / 9007199254740992.0;
+}
+
+//---------------------------------------------------------------------------
+
+void SampleJets(const DelphesBTagScoreSampler *sampler, TJetBatch *batch,
+  size_t begin, size_t end, ULong64_t seed)
+{
+  size_t i;
+
+  if(begin >= end) return;
+
+  for(i = begin; i < end; ++i)
+  {
+    batch->u[i] = Uniform(seed, batch->firstJet + i);
+  }
+
+  sampler->Sample(end - begin, &batch->pt[begin], &batch->eta[begin],
+    &batch->flavor[begin], &batch->u[begin], &batch->score[begin]);
+}
+
+//---------------------------------------------------------------------------
+
+static bool interrupted = false;
+
+void SignalHandler(int sig)
+{
+  interrupted = true;
+}
+
+//---------------------------------------------------------------------------
+
+vector<string> ArgSplitter(char *arg)
+{
+  string s = arg;
+  string delimiter = "=";
+  vector<string> result;
+  size_t first = 0, last = 0;
+
+  while((last = s.find(delimiter, first)) != string::npos)
+  {
+    result.push_back(s.substr(first, last - first));
+    first = last + delimiter.length();
+  }
+
+  result.push_back(s.substr(first, last));
+
+  return result;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "root2btagscore";
+  stringstream message;
+  ExRootConfReader *confReader = 0;
+  DelphesBTagScoreSampler *sampler = 0;
+  JetReader *reader = 0;
+  TFile *inputFile = 0, *outputFile = 0;
+  TTree *inputTree = 0, *outputTree = 0;
+  TBranch *branchScore = 0;
+  TJetBatch batches[2];
+  TJetBatch *batch, *nextBatch;
+  vector<thread> workers;
+  vector<Double_t> ptBins, absEtaBins;
+  vector<string> result;
+  ExRootConfParam param;
+  string moduleName = "PseudoBTagScore", jetBranchName = "Jet", prefix;
+  string tableFile, fileB, fileNonB;
+  Long64_t allEntries, batchSize = 10000, entries, entry, offset;
+  ULong64_t seed = 0;
+  Bool_t seedIsSet = kFALSE;
+  Int_t i, j, size, numberOfThreads = thread::hardware_concurrency();
+  Float_t dummyScore = 0.0;
+  size_t t, numberOfJets;
+
+  i = 1;
+  while(i < argc)
+  {
+    result = ArgSplitter(argv[i]);
+
+    if(result.size() == 2 && result[0].compare(0, 2, "--") == 0)
+    {
+      if(result[0] == "--module")
+        moduleName = result[1];
+      else if(result[0] == "--jet-branch")
+        jetBranchName = result[1];
+      else if(result[0] == "--threads")
+        numberOfThreads = atoi(result[1].c_str());
+      else if(result[0] == "--batch-size")
+        batchSize = atoll(result[1].c_str());
+      else if(result[0] == "--seed")
+      {
+        seed = strtoull(result[1].c_str(), 0, 10);
+        seedIsSet = kTRUE;
+      }
+      else
+        break;
+
+      for(j = i + 1; j < argc; ++j) argv[j - 1] = argv[j];
+      --argc;
+    }
+    else
+    {
+      ++i;
+    }
+  }
+
+  if(argc != 4)
+  {
+    cerr << " Usage: " << appName << " config_file input_file output_file"
+         << " [--module=PseudoBTagScore] [--jet-branch=Jet] [--threads=N] [--batch-size=10000] [--seed=N]" << endl;
+    cerr << " config_file - configuration file in Tcl format with the PseudoBTagScore module," << endl;
+    cerr << " input_file - input file in ROOT format," << endl;
+    cerr << " output_file - output file in ROOT format with the BTagScore friend tree." << endl;
+    cerr << " The seed defaults to the RandomSeed parameter of the module." << endl;
+    return 1;
+  }
+
+  if(numberOfThreads < 1) numberOfThreads = 1;
+  if(batchSize < 1) batchSize = 1;
+
+  signal(SIGINT, SignalHandler);
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    confReader = new ExRootConfReader;
+    confReader->ReadFile(argv[1]);
+
+    prefix = moduleName + "::";
+
+    param = confReader->GetParam((prefix + "PTBins").c_str());
+    for(i = 0; i < param.GetSize(); ++i) ptBins.push_back(param[i].GetDouble());
+
+    param = confReader->GetParam((prefix + "AbsEtaBins").c_str());
+    for(i = 0; i < param.GetSize(); ++i) absEtaBins.push_back(param[i].GetDouble());
+
+    if(!seedIsSet) seed = confReader->GetInt((prefix + "RandomSeed").c_str(), 0);
+
+    tableFile = confReader->GetString((prefix + "Jet_btagDeepFlavB_table").c_str(), "");
+    fileB = confReader->GetString((prefix + "Jet_btagDeepFlavB_file_b").c_str(), "");
+    fileNonB = confReader->GetString((prefix + "Jet_btagDeepFlavB_file_nonb").c_str(), "");
+
+    sampler = new DelphesBTagScoreSampler;
+    if(!tableFile.empty())
+    {
+      sampler->MapTables(tableFile.c_str());
+      if((!ptBins.empty() || !absEtaBins.empty()) && !sampler->HasBins(ptBins, absEtaBins))
+      {
+        message << "PTBins and AbsEtaBins differ from the bin edges in " << tableFile;
+        throw runtime_error(message.str());
+      }
+    }
+    else
+    {
+      sampler->SetBins(ptBins, absEtaBins);
+      sampler->ReadHistograms(fileB.c_str(), fileNonB.c_str());
+    }
+    sampler->Smooth(confReader->GetInt((prefix + "SmoothKnots").c_str(), 0));
+
+    if(strlen(confReader->GetString((prefix + "CopulaCorrelation").c_str(), "")) > 0)
+    {
+      cerr << "** WARNING: CopulaCorrelation is ignored, the jets are sampled independently" << endl;
+    }
+
+    cerr << "** Reading " << argv[2] << endl;
+
+    inputFile = TFile::Open(argv[2]);
+    if(!inputFile || inputFile->IsZombie())
+    {
+      message << "can't open " << argv[2];
+      throw runtime_error(message.str());
+    }
+
+    inputTree = static_cast<TTree *>(inputFile->Get("Delphes"));
+    if(!inputTree)
+    {
+      message << "can't find tree Delphes in " << argv[2];
+      throw runtime_error(message.str());
+    }
+
+    reader = new JetReader(inputTree, jetBranchName.c_str());
+
+    outputFile = TFile::Open(argv[3], "RECREATE");
+    if(!outputFile || outputFile->IsZombie())
+    {
+      message << "can't create output file " << argv[3];
+      throw runtime_error(message.str());
+    }
+
+    outputTree = new TTree("BTagScore", "Pseudo b-tag scores");
+    outputTree->SetDirectory(outputFile);
+    outputTree->Branch((jetBranchName + "_size").c_str(), &size, (jetBranchName + "_size/I").c_str());
+    branchScore = outputTree->Branch((jetBranchName + "_btagDeepFlavB").c_str(), &dummyScore,
+      (jetBranchName + "_btagDeepFlavB[" + jetBranchName + "_size]/F").c_str());
+
+    allEntries = reader->GetEntries();
+    cerr << "** Input file contains " << allEntries << " events" << endl;
+    cerr << "** Sampling with " << numberOfThreads << " threads and seed " << seed << endl;
+
+    if(allEntries > 0)
+    {
+      ExRootProgressBar progressBar(allEntries - 1);
+
+      batch = &batches[0];
+      nextBatch = &batches[1];
+
+      batch->firstJet = 0;
+      entries = reader->ReadBatch(0, batchSize, *batch);
+
+      while(entries > 0 && !interrupted)
+      {
+        // sample the jets of this batch while the next batch is read
+        numberOfJets = batch->pt.size();
+        workers.clear();
+        for(t = 0; t < size_t(numberOfThreads); ++t)
+        {
+          workers.push_back(thread(SampleJets, sampler, batch,
+            numberOfJets * t / numberOfThreads, numberOfJets * (t + 1) / numberOfThreads, seed));
+        }
+
+        nextBatch->firstJet = batch->firstJet + numberOfJets;
+        try
+        {
+          entries = reader->ReadBatch(batch->firstEntry + batch->size.size(), batchSize, *nextBatch);
+        }
+        catch(runtime_error &e)
+        {
+          for(t = 0; t < workers.size(); ++t) workers[t].join();
+          throw;
+        }
+
+        for(t = 0; t < workers.size(); ++t) workers[t].join();
+
+        offset = 0;
+        for(entry = 0; entry < Long64_t(batch->size.size()); ++entry)
+        {
+          size = batch->size[entry];
+          branchScore->SetAddress(size > 0 ? &batch->score[offset] : &dummyScore);
+          outputTree->Fill();
+          offset += size;
+        }
+
+        progressBar.Update(batch->firstEntry + batch->size.size() - 1);
+
+        swap(batch, nextBatch);
+      }
+      progressBar.Finish();
+    }
+
+    outputFile->cd();
+    outputTree->Write();
+
+    cerr << "** Exiting..." << endl;
+
+    delete outputFile;
+    delete reader;
+    delete inputFile;
+    delete sampler;
+    delete confReader;
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    if(outputFile) delete outputFile;
+    if(reader) delete reader;
+    if(inputFile) delete inputFile;
+    if(sampler) delete sampler;
+    if(confReader) delete confReader;
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
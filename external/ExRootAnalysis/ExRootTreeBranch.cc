@@ -23,7 +23,7 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
-ExRootTreeBranch::ExRootTreeBranch(const char *name, TClass *cl, TTree *tree) :
+ExRootTreeBranch::ExRootTreeBranch(const char *name, TClass *cl, TTree *tree, Int_t basketSize) :
   fSize(0), fCapacity(1), fData(0)
 {
   stringstream message;
@@ -38,7 +38,7 @@ ExRootTreeBranch::ExRootTreeBranch(const char *name, TClass *cl, TTree *tree) :
     fData->Clear();
     if(tree)
     {
-      tree->Branch(name, &fData, 64000);
+      tree->Branch(name, &fData, basketSize);
       tree->Branch(TString(name) + "_size", &fSize, TString(name) + "_size/I");
     }
   }
@@ -58,6 +58,13 @@ ExRootTreeBranch::~ExRootTreeBranch()
 
 //------------------------------------------------------------------------------
 
+const char *ExRootTreeBranch::GetName() const
+{
+  return fData ? fData->GetName() : "";
+}
+
+//------------------------------------------------------------------------------
+
 TObject *ExRootTreeBranch::NewEntry()
 {
   if(!fData) return 0;
@@ -86,6 +93,15 @@ TObject *ExRootTreeBranch::NewEntry()
 
 //------------------------------------------------------------------------------
 
+TObject *ExRootTreeBranch::At(Int_t index)
+{
+  if(!fData || index < 0 || index >= fSize) return 0;
+
+  return fData->AddrAt(index);
+}
+
+//------------------------------------------------------------------------------
+
 void ExRootTreeBranch::Clear()
 {
   fSize = 0;
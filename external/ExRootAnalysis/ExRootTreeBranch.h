@@ -18,12 +18,16 @@ class TClonesArray;
 class ExRootTreeBranch
 {
 public:
-  ExRootTreeBranch(const char *name, TClass *cl, TTree *tree = 0);
+  ExRootTreeBranch(const char *name, TClass *cl, TTree *tree = 0, Int_t basketSize = 64000);
   ~ExRootTreeBranch();
 
   TObject *NewEntry();
   void Clear();
 
+  Int_t GetSize() const { return fSize; }
+  const char *GetName() const;
+  TObject *At(Int_t index);
+
 private:
   Int_t fSize, fCapacity; //!
   TClonesArray *fData; //!
@@ -0,0 +1,158 @@
+
+/** \class ExRootTreeFlatBranch
+ *
+ *  Class handling flat (columnar) output ROOT tree branches.
+ *  Each column is written as a plain array of basic types,
+ *  sized by the "<name>_size" counter branch.
+ *
+ */
+
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
+
+#include "TBranch.h"
+#include "TString.h"
+#include "TTree.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+ExRootTreeFlatBranch::ExRootTreeFlatBranch(const char *name, TTree *tree, Int_t basketSize) :
+  fName(name), fTree(tree), fSize(0), fCapacity(10), fBasketSize(basketSize)
+{
+  if(fTree)
+  {
+    fTree->Branch(fName + "_size", &fSize, fName + "_size/I");
+  }
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeFlatBranch::~ExRootTreeFlatBranch()
+{
+  vector<Column *>::iterator itColumns;
+  for(itColumns = fColumns.begin(); itColumns != fColumns.end(); ++itColumns)
+  {
+    delete(*itColumns);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Int_t ExRootTreeFlatBranch::AddColumn(const char *name, Char_t type)
+{
+  stringstream message;
+  Int_t typeSize;
+
+  switch(type)
+  {
+    case 'F': typeSize = sizeof(Float_t); break;
+    case 'D': typeSize = sizeof(Double_t); break;
+    case 'I': typeSize = sizeof(Int_t); break;
+    case 'i': typeSize = sizeof(UInt_t); break;
+    case 'O': typeSize = sizeof(Bool_t); break;
+    default:
+      message << "can't create column '" << fName << "_" << name << "' of type '" << type << "'";
+      throw runtime_error(message.str());
+  }
+
+  Column *column = new Column;
+
+  column->name = fName + "_" + name;
+  column->type = type;
+  column->typeSize = typeSize;
+  column->data.resize(fCapacity * typeSize);
+  column->branch = 0;
+
+  if(fTree)
+  {
+    column->branch = fTree->Branch(column->name, &column->data[0],
+      column->name + "[" + fName + "_size]/" + type, fBasketSize);
+  }
+
+  fColumns.push_back(column);
+  return fColumns.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatBranch::SetBasketSize(Int_t size)
+{
+  vector<Column *>::iterator itColumns;
+
+  fBasketSize = size;
+
+  for(itColumns = fColumns.begin(); itColumns != fColumns.end(); ++itColumns)
+  {
+    if((*itColumns)->branch) (*itColumns)->branch->SetBasketSize(fBasketSize);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatBranch::Expand()
+{
+  vector<Column *>::iterator itColumns;
+
+  if(fCapacity < 100)
+    fCapacity = 100;
+  else if(fCapacity < 250)
+    fCapacity = 250;
+  else
+    fCapacity *= 2;
+
+  // buffers may move, so the branch addresses have to be reset
+  for(itColumns = fColumns.begin(); itColumns != fColumns.end(); ++itColumns)
+  {
+    (*itColumns)->data.resize(fCapacity * (*itColumns)->typeSize);
+    if((*itColumns)->branch) (*itColumns)->branch->SetAddress(&(*itColumns)->data[0]);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Int_t ExRootTreeFlatBranch::NewEntry()
+{
+  if(fSize >= fCapacity) Expand();
+
+  return fSize++;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatBranch::Clear()
+{
+  fSize = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void *ExRootTreeFlatBranch::GetAddress(Int_t column, Int_t entry)
+{
+  Column *c = fColumns[column];
+  return &c->data[entry * c->typeSize];
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatBranch::SetValue(Int_t column, Int_t entry, Double_t value)
+{
+  Column *c = fColumns[column];
+  void *address = &c->data[entry * c->typeSize];
+
+  switch(c->type)
+  {
+    case 'F': *static_cast<Float_t *>(address) = value; break;
+    case 'D': *static_cast<Double_t *>(address) = value; break;
+    case 'I': *static_cast<Int_t *>(address) = Int_t(value); break;
+    case 'i': *static_cast<UInt_t *>(address) = UInt_t(value); break;
+    case 'O': *static_cast<Bool_t *>(address) = (value != 0.0); break;
+  }
+}
+
+//------------------------------------------------------------------------------
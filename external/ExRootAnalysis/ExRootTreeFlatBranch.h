@@ -0,0 +1,60 @@
+#ifndef ExRootTreeFlatBranch_h
+#define ExRootTreeFlatBranch_h
+
+/** \class ExRootTreeFlatBranch
+ *
+ *  Class handling flat (columnar) output ROOT tree branches.
+ *  Each column is written as a plain array of basic types,
+ *  sized by the "<name>_size" counter branch.
+ *
+ */
+
+#include "Rtypes.h"
+#include "TString.h"
+
+#include <vector>
+
+class TTree;
+class TBranch;
+
+class ExRootTreeFlatBranch
+{
+public:
+  ExRootTreeFlatBranch(const char *name, TTree *tree = 0, Int_t basketSize = 32000);
+  ~ExRootTreeFlatBranch();
+
+  // type follows the TTree leaf codes: 'F', 'D', 'I', 'i', 'O'
+  Int_t AddColumn(const char *name, Char_t type);
+
+  Int_t NewEntry();
+  void Clear();
+
+  Int_t GetSize() const { return fSize; }
+  const char *GetName() const { return fName.Data(); }
+
+  // also applies to the columns created before
+  void SetBasketSize(Int_t size);
+
+  void *GetAddress(Int_t column, Int_t entry);
+  Int_t GetTypeSize(Int_t column) const { return fColumns[column]->typeSize; }
+  void SetValue(Int_t column, Int_t entry, Double_t value);
+
+private:
+  struct Column
+  {
+    TString name;
+    Char_t type;
+    Int_t typeSize;
+    std::vector<Char_t> data;
+    TBranch *branch;
+  };
+
+  void Expand();
+
+  TString fName; //!
+  TTree *fTree; //!
+  Int_t fSize, fCapacity, fBasketSize; //!
+  std::vector<Column *> fColumns; //!
+};
+
+#endif /* ExRootTreeFlatBranch */
@@ -9,9 +9,13 @@
 
 #include "ExRootAnalysis/ExRootTreeWriter.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
 
-#include "TParameter.h"
+#include "Compression.h"
+#include "TBranch.h"
 #include "TClonesArray.h"
+#include "TObjArray.h"
+#include "TParameter.h"
 #include "TFile.h"
 #include "TROOT.h"
 #include "TTree.h"
@@ -22,8 +26,28 @@
 
 using namespace std;
 
+//------------------------------------------------------------------------------
+
+static void SetBranchBasketSize(TBranch *branch, Int_t size)
+{
+  TBranch *subBranch;
+
+  if(!branch) return;
+
+  branch->SetBasketSize(size);
+
+  TIter itSubBranches(branch->GetListOfBranches());
+  while((subBranch = static_cast<TBranch *>(itSubBranches.Next())))
+  {
+    SetBranchBasketSize(subBranch, size);
+  }
+}
+
+//------------------------------------------------------------------------------
+
 ExRootTreeWriter::ExRootTreeWriter(TFile *file, const char *treeName) :
-  fFile(file), fTree(0), fTreeName(treeName)
+  fFile(file), fTree(0), fTreeName(treeName), fBasketSize(64000),
+  fAutoFlush(-30000000), fAutoSave(10000000)
 {
 }
 
@@ -37,6 +61,12 @@ ExRootTreeWriter::~ExRootTreeWriter()
     delete(*itBranches);
   }
 
+  set<ExRootTreeFlatBranch *>::iterator itFlatBranches;
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    delete(*itFlatBranches);
+  }
+
   if(fTree) delete fTree;
 }
 
@@ -45,13 +75,23 @@ ExRootTreeWriter::~ExRootTreeWriter()
 ExRootTreeBranch *ExRootTreeWriter::NewBranch(const char *name, TClass *cl)
 {
   if(!fTree) fTree = NewTree();
-  ExRootTreeBranch *branch = new ExRootTreeBranch(name, cl, fTree);
+  ExRootTreeBranch *branch = new ExRootTreeBranch(name, cl, fTree, GetBasketSize(name));
   fBranches.insert(branch);
   return branch;
 }
 
 //------------------------------------------------------------------------------
 
+ExRootTreeFlatBranch *ExRootTreeWriter::NewFlatBranch(const char *name)
+{
+  if(!fTree) fTree = NewTree();
+  ExRootTreeFlatBranch *branch = new ExRootTreeFlatBranch(name, fTree, GetBasketSize(name));
+  fFlatBranches.insert(branch);
+  return branch;
+}
+
+//------------------------------------------------------------------------------
+
 void ExRootTreeWriter::AddInfo(const char *name, Double_t value)
 {
   if(!fTree) fTree = NewTree();
@@ -60,6 +100,139 @@ void ExRootTreeWriter::AddInfo(const char *name, Double_t value)
 
 //------------------------------------------------------------------------------
 
+void ExRootTreeWriter::SetCompression(const char *algorithm, Int_t level)
+{
+  stringstream message;
+  TString name(algorithm);
+  Int_t code;
+
+  name.ToUpper();
+  if(name == "ZLIB")
+    code = ROOT::RCompressionSetting::EAlgorithm::kZLIB;
+  else if(name == "LZMA")
+    code = ROOT::RCompressionSetting::EAlgorithm::kLZMA;
+  else if(name == "LZ4")
+    code = ROOT::RCompressionSetting::EAlgorithm::kLZ4;
+  else if(name == "ZSTD")
+    code = ROOT::RCompressionSetting::EAlgorithm::kZSTD;
+  else
+  {
+    message << "unknown compression algorithm '" << algorithm << "'";
+    throw runtime_error(message.str());
+  }
+
+  if(!fFile)
+  {
+    throw runtime_error("can't set compression without output ROOT file");
+  }
+
+  // branches take the compression settings of the file when they are created
+  fFile->SetCompressionAlgorithm(code);
+  fFile->SetCompressionLevel(level);
+
+  UpdateCompression();
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetCompressionLevel(Int_t level)
+{
+  if(!fFile)
+  {
+    throw runtime_error("can't set compression without output ROOT file");
+  }
+
+  fFile->SetCompressionLevel(level);
+
+  UpdateCompression();
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::UpdateCompression()
+{
+  TBranch *branch;
+
+  if(!fTree) return;
+
+  // branches created before copied the previous settings of the file,
+  // TBranch::SetCompressionSettings also updates their sub-branches
+  TIter itBranches(fTree->GetListOfBranches());
+  while((branch = static_cast<TBranch *>(itBranches.Next())))
+  {
+    branch->SetCompressionSettings(fFile->GetCompressionSettings());
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetBasketSize(Int_t size)
+{
+  fBasketSize = size;
+  UpdateBasketSizes();
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetBasketSize(const char *name, Int_t size)
+{
+  fBasketSizes[name] = size;
+  UpdateBasketSizes();
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::UpdateBasketSizes()
+{
+  if(!fTree) return;
+
+  set<ExRootTreeBranch *>::iterator itBranches;
+  for(itBranches = fBranches.begin(); itBranches != fBranches.end(); ++itBranches)
+  {
+    SetBranchBasketSize(fTree->GetBranch((*itBranches)->GetName()), GetBasketSize((*itBranches)->GetName()));
+  }
+
+  set<ExRootTreeFlatBranch *>::iterator itFlatBranches;
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    (*itFlatBranches)->SetBasketSize(GetBasketSize((*itFlatBranches)->GetName()));
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetAutoFlush(Long64_t autoFlush)
+{
+  fAutoFlush = autoFlush;
+  if(fTree) fTree->SetAutoFlush(fAutoFlush);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetAutoSave(Long64_t autoSave)
+{
+  fAutoSave = autoSave;
+  if(fTree) fTree->SetAutoSave(fAutoSave);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::EnableImplicitMT(UInt_t threads)
+{
+  ROOT::EnableImplicitMT(threads);
+  if(fTree) fTree->SetImplicitMT(kTRUE);
+}
+
+//------------------------------------------------------------------------------
+
+Int_t ExRootTreeWriter::GetBasketSize(const char *name) const
+{
+  map<TString, Int_t>::const_iterator itBasketSizes = fBasketSizes.find(name);
+  return itBasketSizes != fBasketSizes.end() ? itBasketSizes->second : fBasketSize;
+}
+
+//------------------------------------------------------------------------------
+
 void ExRootTreeWriter::Fill()
 {
   if(fTree) fTree->Fill();
@@ -75,6 +248,15 @@ void ExRootTreeWriter::Write()
 
 //------------------------------------------------------------------------------
 
+void ExRootTreeWriter::Flush()
+{
+  // save the tree header so that the entries written so far
+  // can be recovered if the job is interrupted
+  if(fTree) fTree->AutoSave("SaveSelf");
+}
+
+//------------------------------------------------------------------------------
+
 void ExRootTreeWriter::Clear()
 {
   set<ExRootTreeBranch *>::iterator itBranches;
@@ -82,6 +264,12 @@ void ExRootTreeWriter::Clear()
   {
     (*itBranches)->Clear();
   }
+
+  set<ExRootTreeFlatBranch *>::iterator itFlatBranches;
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    (*itFlatBranches)->Clear();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -103,7 +291,9 @@ TTree *ExRootTreeWriter::NewTree()
   }
 
   tree->SetDirectory(fFile);
-  tree->SetAutoSave(10000000); // autosave when 10 MB written
+  tree->SetAutoSave(fAutoSave); // autosave when 10 MB written by default
+  tree->SetAutoFlush(fAutoFlush); // flush baskets every 30 MB by default
+  tree->SetImplicitMT(kTRUE);
 
   return tree;
 }
@@ -10,13 +10,16 @@
  */
 
 #include "TNamed.h"
+#include "TString.h"
 
+#include <map>
 #include <set>
 
 class TFile;
 class TTree;
 class TClass;
 class ExRootTreeBranch;
+class ExRootTreeFlatBranch;
 
 class ExRootTreeWriter: public TNamed
 {
@@ -31,21 +34,44 @@ public:
   void SetTree(TTree* t) { fTree = t; }
 
   ExRootTreeBranch *NewBranch(const char *name, TClass *cl);
+  ExRootTreeFlatBranch *NewFlatBranch(const char *name);
   void AddInfo(const char *name, Double_t value);
 
+  // algorithm is one of ZLIB, LZMA, LZ4 or ZSTD,
+  // SetCompressionLevel keeps the algorithm of the output file,
+  // both also apply to the branches created before
+  void SetCompression(const char *algorithm, Int_t level);
+  void SetCompressionLevel(Int_t level);
+  void SetBasketSize(Int_t size);
+  void SetBasketSize(const char *name, Int_t size);
+  void SetAutoFlush(Long64_t autoFlush);
+  void SetAutoSave(Long64_t autoSave);
+  // compress baskets in parallel using ROOT implicit multi-threading,
+  // 0 lets ROOT choose the number of threads
+  void EnableImplicitMT(UInt_t threads);
+
   void Clear();
   void Fill();
   void Write();
+  void Flush();
 
 private:
   TTree *NewTree();
+  Int_t GetBasketSize(const char *name) const;
+  void UpdateCompression();
+  void UpdateBasketSizes();
 
   TFile *fFile; //!
   TTree *fTree; //!
 
   TString fTreeName; //!
 
+  Int_t fBasketSize; //!
+  std::map<TString, Int_t> fBasketSizes; //!
+  Long64_t fAutoFlush, fAutoSave; //!
+
   std::set<ExRootTreeBranch *> fBranches; //!
+  std::set<ExRootTreeFlatBranch *> fFlatBranches; //!
 
   ClassDef(ExRootTreeWriter, 1)
 };
@@ -48,7 +48,9 @@
 #include "TString.h"
 
 #include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 
@@ -58,7 +60,7 @@
 using namespace std;
 
 Delphes::Delphes(const char *name) :
-  fFactory(0)
+  fFactory(0), fEventRejected(kFALSE)
 {
   TFolder *folder;
 
@@ -123,6 +125,40 @@ void Delphes::Init()
 
   gRandom->SetSeed(confReader->GetInt("::RandomSeed", 0));
 
+  // output tree settings, also applied to the branches
+  // created by the readers before the initialization
+
+  ExRootTreeWriter *treeWriter = static_cast<ExRootTreeWriter *>(GetObject("TreeWriter", ExRootTreeWriter::Class()));
+  if(treeWriter)
+  {
+    ExRootConfParam basketSizes = confReader->GetParam("::BasketSizes");
+    Long_t j;
+
+    if(confReader->GetParam("::CompressionAlgorithm").GetSize() > 0)
+    {
+      treeWriter->SetCompression(confReader->GetString("::CompressionAlgorithm", "ZLIB"),
+        confReader->GetInt("::CompressionLevel", 1));
+    }
+    else if(confReader->GetParam("::CompressionLevel").GetSize() > 0)
+    {
+      treeWriter->SetCompressionLevel(confReader->GetInt("::CompressionLevel", 1));
+    }
+
+    treeWriter->SetBasketSize(confReader->GetInt("::BasketSize", 64000));
+    for(j = 0; j < basketSizes.GetSize() / 2; ++j)
+    {
+      treeWriter->SetBasketSize(basketSizes[j * 2].GetString(), basketSizes[j * 2 + 1].GetInt());
+    }
+
+    treeWriter->SetAutoFlush(confReader->GetLong("::AutoFlush", -30000000));
+    treeWriter->SetAutoSave(confReader->GetLong("::AutoSave", 10000000));
+
+    if(confReader->GetBool("::ImplicitMT", false))
+    {
+      treeWriter->EnableImplicitMT(confReader->GetInt("::ImplicitMTThreads", 0));
+    }
+  }
+
   for(i = 0; i < size; ++i)
   {
     name = param[i].GetString();
@@ -147,14 +183,149 @@ void Delphes::Init()
 
 //------------------------------------------------------------------------------
 
+void Delphes::InitTask()
+{
+  // modules import and export their arrays in Init,
+  // so the dataflow is known only after all of them are initialized
+  DelphesModule::InitTask();
+  FindUnusedModules();
+}
+
+//------------------------------------------------------------------------------
+
+void Delphes::FindUnusedModules()
+{
+  ExRootConfReader *confReader = GetConfReader();
+  ExRootConfParam param = confReader->GetParam("::KeepModules");
+  Bool_t skip = confReader->GetBool("::SkipUnusedModules", false);
+  Long_t i, size = param.GetSize();
+
+  set<TString> keep, consumed;
+  set<DelphesModule *> live;
+  vector<DelphesModule *> modules;
+  vector<DelphesModule *>::const_iterator itModules;
+  vector<TString>::const_iterator itArrays;
+  DelphesModule *module;
+  TFolder *folder;
+  TObject *object;
+  Bool_t changed, used;
+
+  for(i = 0; i < size; ++i)
+  {
+    keep.insert(param[i].GetString());
+  }
+
+  TIter itTasks(GetListOfTasks());
+  while((module = static_cast<DelphesModule *>(itTasks.Next())))
+  {
+    if(module->IsActive()) modules.push_back(module);
+  }
+
+  // a module is used if it writes to the output tree, fills plots,
+  // exports nothing (filters, taggers modifying their inputs in place),
+  // is listed in KeepModules, or exports an array imported by a used module
+  do
+  {
+    changed = kFALSE;
+    for(itModules = modules.begin(); itModules != modules.end(); ++itModules)
+    {
+      module = *itModules;
+      if(live.count(module)) continue;
+
+      folder = module->GetExportFolder();
+      used = module->HasOutput() || !folder || keep.count(module->GetName());
+
+      if(!used)
+      {
+        TIter itExports(folder->GetListOfFolders());
+        while((object = itExports.Next()))
+        {
+          if(consumed.count(TString(module->GetName()) + "/" + object->GetName()))
+          {
+            used = kTRUE;
+            break;
+          }
+        }
+      }
+
+      if(!used) continue;
+
+      live.insert(module);
+      changed = kTRUE;
+
+      const vector<TString> &imports = module->GetImportedArrays();
+      for(itArrays = imports.begin(); itArrays != imports.end(); ++itArrays)
+      {
+        consumed.insert(*itArrays);
+      }
+    }
+  } while(changed);
+
+  cout << left;
+  for(itModules = modules.begin(); itModules != modules.end(); ++itModules)
+  {
+    module = *itModules;
+    if(live.count(module)) continue;
+
+    if(skip)
+    {
+      cout << setw(30) << "** INFO: skipping unused module";
+      module->SetActive(kFALSE);
+      fSkippedModules.push_back(module);
+    }
+    else
+    {
+      cout << setw(30) << "** INFO: unused module";
+    }
+    cout << setw(25) << module->GetName() << endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+
 void Delphes::Process()
 {
 }
 
 //------------------------------------------------------------------------------
 
+void Delphes::ProcessTask()
+{
+  TIter itModules(GetListOfTasks());
+  DelphesModule *module;
+
+  fEventRejected = kFALSE;
+
+  Process();
+
+  // run the modules in the order of the execution path,
+  // and stop as soon as one of them rejects the event
+  while((module = static_cast<DelphesModule *>(itModules.Next())))
+  {
+    if(!module->IsActive()) continue;
+
+    module->ProcessTask();
+
+    if(module->IsEventRejected())
+    {
+      fEventRejected = kTRUE;
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
 void Delphes::Finish()
 {
+  vector<DelphesModule *>::const_iterator itModules;
+
+  // skipped modules were initialized, let them finish as well
+  for(itModules = fSkippedModules.begin(); itModules != fSkippedModules.end(); ++itModules)
+  {
+    (*itModules)->SetActive(kTRUE);
+  }
+  fSkippedModules.clear();
 }
 
 //------------------------------------------------------------------------------
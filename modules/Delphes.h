@@ -30,6 +30,8 @@
 
 #include "classes/DelphesModule.h"
 
+#include <vector>
+
 class TFolder;
 class TObjArray;
 
@@ -53,9 +55,20 @@ public:
   virtual void Process();
   virtual void Finish();
 
+  virtual void InitTask();
+  virtual void ProcessTask();
+
+  Bool_t IsEventRejected() const { return fEventRejected; }
+
 private:
+  void FindUnusedModules();
+
   DelphesFactory *fFactory;
 
+  std::vector<DelphesModule *> fSkippedModules; //!
+
+  Bool_t fEventRejected;
+
   ClassDef(Delphes, 1)
 };
 
@@ -27,8 +27,10 @@
 #include "modules/Efficiency.h"
 
 #include "classes/DelphesClasses.h"
+#include "classes/DelphesDensityGrid.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
+#include "classes/DelphesFormulaGrid.h"
 
 #include "ExRootAnalysis/ExRootClassifier.h"
 #include "ExRootAnalysis/ExRootFilter.h"
@@ -52,9 +54,10 @@ using namespace std;
 //------------------------------------------------------------------------------
 
 Efficiency::Efficiency() :
-  fFormula(0), fItInputArray(0)
+  fFormula(0), fGrid(0), fItInputArray(0), fDensityMapInputArray(0)
 {
   fFormula = new DelphesFormula;
+  fGrid = new DelphesFormulaGrid;
 }
 
 //------------------------------------------------------------------------------
@@ -62,6 +65,7 @@ Efficiency::Efficiency() :
 Efficiency::~Efficiency()
 {
   if(fFormula) delete fFormula;
+  if(fGrid) delete fGrid;
 }
 
 //------------------------------------------------------------------------------
@@ -72,6 +76,10 @@ void Efficiency::Init()
 
   fFormula->Compile(GetString("EfficiencyFormula", "1.0"));
 
+  // switch to evaluate the formula on a piecewise-constant (pt, eta) grid
+  fCompileFormulas = GetBool("CompileFormulas", false);
+  if(fCompileFormulas) fGrid->Build(fFormula, GetString("EfficiencyFormula", "1.0"));
+
   // import input array
 
   fInputArray = ImportArray(GetString("InputArray", "ParticlePropagator/stableParticles"));
@@ -80,6 +88,15 @@ void Efficiency::Init()
   // switch to compute efficiency based on momentum vector eta, phi
   fUseMomentumVector = GetBool("UseMomentumVector", false);
 
+  // import density map exported by ParticleDensity (optional),
+  // used for the density variable of the formula and written
+  // on the accepted candidates, which are then clones of the input ones
+
+  if(TString(GetString("DensityMapInputArray", "")).Length() > 0)
+  {
+    fDensityMapInputArray = ImportArray(GetString("DensityMapInputArray", ""));
+  }
+
   // create output array
 
   fOutputArray = ExportArray(GetString("OutputArray", "stableParticles"));
@@ -96,9 +113,14 @@ void Efficiency::Finish()
 
 void Efficiency::Process()
 {
-  Candidate *candidate;
-  Double_t pt, eta, phi, e;
+  Candidate *candidate, *mother;
+  Double_t pt, eta, phi, e, efficiency, density = 0.0;
+  DelphesDensityGrid *densityMap = 0;
 
+  if(fDensityMapInputArray && fDensityMapInputArray->GetEntriesFast() > 0)
+  {
+    densityMap = static_cast<DelphesDensityGrid *>(fDensityMapInputArray->At(0));
+  }
 
   fItInputArray->Reset();
   while((candidate = static_cast<Candidate *>(fItInputArray->Next())))
@@ -116,8 +138,31 @@ void Efficiency::Process()
     pt = candidateMomentum.Pt();
     e = candidateMomentum.E();
 
-    // apply an efficency formula
-    if(gRandom->Uniform() > fFormula->Eval(pt, eta, phi, e, candidate)) continue;
+    // apply an efficency formula, the density from the map is only
+    // written on a clone of the accepted candidate, as the input candidate
+    // can be shared with other arrays
+    if(densityMap)
+    {
+      density = densityMap->GetDensity(candidate);
+      if(fCompileFormulas)
+        efficiency = fGrid->Eval(pt, eta, phi, e, candidate, density);
+      else
+        efficiency = fFormula->Eval(pt, eta, phi, e, candidate, density);
+    }
+    else if(fCompileFormulas)
+      efficiency = fGrid->Eval(pt, eta, phi, e, candidate);
+    else
+      efficiency = fFormula->Eval(pt, eta, phi, e, candidate);
+
+    if(gRandom->Uniform() > efficiency) continue;
+
+    if(densityMap)
+    {
+      mother = candidate;
+      candidate = static_cast<Candidate *>(candidate->Clone());
+      candidate->ParticleDensity = density;
+      candidate->AddCandidate(mother);
+    }
 
     fOutputArray->Add(candidate);
   }
@@ -32,6 +32,7 @@
 class TIterator;
 class TObjArray;
 class DelphesFormula;
+class DelphesFormulaGrid;
 
 class Efficiency: public DelphesModule
 {
@@ -46,10 +47,16 @@ public:
 private:
   DelphesFormula *fFormula; //!
 
+  DelphesFormulaGrid *fGrid; //!
+
+  Bool_t fCompileFormulas; //!
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
 
+  const TObjArray *fDensityMapInputArray; //!
+
   TObjArray *fOutputArray; //!
 
   Double_t fUseMomentumVector; //!
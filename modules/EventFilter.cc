@@ -0,0 +1,132 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \class EventFilter
+ *
+ *  Rejects events that fail a selection on the imported arrays.
+ *  Each selection requires a minimum number of candidates passing
+ *  pT, |eta| and Jet_btagDeepFlavB cuts; all selections must be passed.
+ *  Modules after EventFilter in the execution path are not run
+ *  for rejected events, and these events are not written.
+ *
+ */
+
+#include "modules/EventFilter.h"
+
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+
+#include "TLorentzVector.h"
+#include "TMath.h"
+#include "TObjArray.h"
+#include "TString.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+EventFilter::EventFilter() :
+  fRejected(kFALSE), fEventCounter(0), fAcceptedCounter(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+EventFilter::~EventFilter()
+{
+}
+
+//------------------------------------------------------------------------------
+
+void EventFilter::Init()
+{
+  // read selections: input array, minimum number of candidates,
+  // minimum pT, maximum |eta| and minimum b-tagging score
+  // (a negative |eta| or score cut is not applied)
+
+  ExRootConfParam param = GetParam("Selection");
+  Long_t i, size;
+  TSelection selection;
+
+  fSelections.clear();
+
+  size = param.GetSize();
+  for(i = 0; i < size / 5; ++i)
+  {
+    selection.array = ImportArray(param[i * 5].GetString());
+    selection.minCount = param[i * 5 + 1].GetInt();
+    selection.minPT = param[i * 5 + 2].GetDouble();
+    selection.maxAbsEta = param[i * 5 + 3].GetDouble();
+    selection.minBTagScore = param[i * 5 + 4].GetDouble();
+
+    fSelections.push_back(selection);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void EventFilter::Finish()
+{
+  cout << "** INFO: " << GetName() << " accepted " << fAcceptedCounter;
+  cout << " out of " << fEventCounter << " events" << endl;
+}
+
+//------------------------------------------------------------------------------
+
+void EventFilter::Process()
+{
+  vector<TSelection>::const_iterator itSelections;
+  Candidate *candidate;
+  Int_t i, size, count;
+
+  ++fEventCounter;
+
+  fRejected = kFALSE;
+  for(itSelections = fSelections.begin(); itSelections != fSelections.end(); ++itSelections)
+  {
+    const TSelection &selection = *itSelections;
+
+    count = 0;
+    size = selection.array->GetEntriesFast();
+    for(i = 0; i < size && count < selection.minCount; ++i)
+    {
+      candidate = static_cast<Candidate *>(selection.array->At(i));
+      const TLorentzVector &momentum = candidate->Momentum;
+
+      if(momentum.Pt() < selection.minPT) continue;
+      if(selection.maxAbsEta >= 0.0 && TMath::Abs(momentum.Eta()) > selection.maxAbsEta) continue;
+      if(selection.minBTagScore >= 0.0 && candidate->Jet_btagDeepFlavB < selection.minBTagScore) continue;
+
+      ++count;
+    }
+
+    if(count < selection.minCount)
+    {
+      fRejected = kTRUE;
+      return;
+    }
+  }
+
+  ++fAcceptedCounter;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,67 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EventFilter_h
+#define EventFilter_h
+
+/** \class EventFilter
+ *
+ *  Rejects events that fail a selection on the imported arrays.
+ *  Each selection requires a minimum number of candidates passing
+ *  pT, |eta| and Jet_btagDeepFlavB cuts; all selections must be passed.
+ *  Modules after EventFilter in the execution path are not run
+ *  for rejected events, and these events are not written.
+ *
+ */
+
+#include "classes/DelphesModule.h"
+
+#include <vector>
+
+class TObjArray;
+
+class EventFilter: public DelphesModule
+{
+public:
+  EventFilter();
+  ~EventFilter();
+
+  void Init();
+  void Process();
+  void Finish();
+
+  Bool_t IsEventRejected() const { return fRejected; }
+
+private:
+  struct TSelection
+  {
+    const TObjArray *array;
+    Int_t minCount;
+    Double_t minPT, maxAbsEta, minBTagScore;
+  };
+
+  std::vector<TSelection> fSelections; //!
+
+  Bool_t fRejected; //!
+
+  Long64_t fEventCounter, fAcceptedCounter; //!
+
+  ClassDef(EventFilter, 1)
+};
+
+#endif
@@ -43,20 +43,26 @@
 #include "TString.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 
+#include "Hector/H_Aperture.h"
 #include "Hector/H_BeamLine.h"
 #include "Hector/H_BeamParticle.h"
+#include "Hector/H_OpticalElement.h"
+#include "Hector/H_Parameters.h"
 #include "Hector/H_RecRPObject.h"
 
 using namespace std;
 
+extern bool relative_energy;
+
 //------------------------------------------------------------------------------
 
 Hector::Hector() :
-  fBeamLine(0), fItInputArray(0)
+  fBeamLine(0), fUseTransportTable(kFALSE), fItInputArray(0)
 {
 }
 
@@ -88,6 +94,17 @@ void Hector::Init()
   fBeamLine->offsetElements(fOffsetS, fOffsetX);
   fBeamLine->calcMatrix();
 
+  // read parameters of the linearised transport
+
+  fUseTransportTable = GetBool("UseTransportTable", false);
+  fXiBins = GetInt("TransportTableXiBins", 200);
+  fXiMax = GetDouble("TransportTableXiMax", 0.2);
+  fTBins = GetInt("TransportTableTBins", 50);
+  fTMax = GetDouble("TransportTableTMax", 4.0);
+  fPhiBins = GetInt("TransportTablePhiBins", 36);
+
+  if(fUseTransportTable) BuildTransportTable();
+
   // import input array
 
   fInputArray = ImportArray(GetString("InputArray", "ParticlePropagator/stableParticles"));
@@ -108,12 +125,217 @@ void Hector::Finish()
 
 //------------------------------------------------------------------------------
 
+void Hector::BuildTransportTable()
+{
+  // each table node holds the x, tan(tx), y and tan(ty) columns of the affine
+  // map from the interaction point to Distance, in Hector's internal units
+
+  const Int_t numberOfElements = fBeamLine->getNumberOfElements();
+  const Int_t numberOfCells = fTBins * fPhiBins;
+  const H_OpticalElement *element;
+  Double_t cumulative[6][6], transfer[6][6], product[6][6], offset[6];
+  Double_t previous[6][6], weight, sPrevious, sExit;
+  Double_t xi, eloss, energy, theta, phi, t, tx, ty;
+  Int_t i, j, k, l, n, cell, last;
+  Bool_t inside;
+
+  if(fXiBins < 1 || fTBins < 1 || fPhiBins < 1 || fXiMax <= 0.0 || fTMax <= 0.0)
+  {
+    throw runtime_error("Hector: transport table binning must be positive");
+  }
+
+  // find the element whose exit brackets Distance, as H_BeamParticle::propagate does
+
+  last = -1;
+  sPrevious = 0.0;
+  for(i = 0; i < numberOfElements; ++i)
+  {
+    element = fBeamLine->getElement(i);
+    sExit = element->getS() + element->getLength();
+    if(sExit >= fDistance)
+    {
+      last = i;
+      break;
+    }
+    sPrevious = sExit;
+  }
+
+  if(last < 0)
+  {
+    throw runtime_error("Hector: Distance is beyond the end of the beam line");
+  }
+
+  weight = (sExit > sPrevious) ? (fDistance - sPrevious) / (sExit - sPrevious) : 1.0;
+
+  fTransportTable.assign((fXiBins + 1) * 24, 0.0);
+  fAcceptanceTable.assign((fXiBins + 1) * numberOfCells, kTRUE);
+
+  vector<Double_t> start(numberOfCells * 6), entrance(numberOfCells * 2);
+
+  for(n = 0; n <= fXiBins; ++n)
+  {
+    xi = fXiMax * n / fXiBins;
+    eloss = xi * BE;
+    energy = BE - eloss;
+
+    // initial states of the acceptance cells, taken at the cell centres
+
+    for(cell = 0; cell < numberOfCells; ++cell)
+    {
+      t = fTMax * ((cell / fPhiBins) + 0.5) / fTBins;
+      phi = -TMath::Pi() + TMath::TwoPi() * ((cell % fPhiBins) + 0.5) / fPhiBins;
+      theta = TMath::Sqrt(t) / energy;
+      tx = URAD * theta * TMath::Cos(phi);
+      ty = URAD * theta * TMath::Sin(phi);
+
+      start[cell * 6 + 0] = 0.0;
+      start[cell * 6 + 1] = TMath::Tan(tx / URAD);
+      start[cell * 6 + 2] = 0.0;
+      start[cell * 6 + 3] = TMath::Tan(ty / URAD);
+      start[cell * 6 + 4] = relative_energy ? -eloss : energy;
+      start[cell * 6 + 5] = 1.0;
+
+      entrance[cell * 2 + 0] = 0.0;
+      entrance[cell * 2 + 1] = 0.0;
+    }
+
+    for(i = 0; i < 6; ++i)
+    {
+      for(j = 0; j < 6; ++j) cumulative[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+
+    for(k = 0; k < numberOfElements; ++k)
+    {
+      element = fBeamLine->getElement(k);
+      TMatrix elementMatrix = element->getMatrix(eloss, MP, QP);
+
+      // fold the misalignment shifts of H_BeamParticle::computePath into the
+      // last row, so that v' = (v - o) M + o becomes v' = v T for v[5] = 1
+
+      offset[0] = element->getX();
+      offset[1] = TMath::Tan(element->getTX() / URAD) * URAD;
+      offset[2] = element->getY();
+      offset[3] = TMath::Tan(element->getTY() / URAD) * URAD;
+      offset[4] = 0.0;
+      offset[5] = 0.0;
+
+      for(i = 0; i < 6; ++i)
+      {
+        for(j = 0; j < 6; ++j) transfer[i][j] = elementMatrix(i, j);
+      }
+      for(j = 0; j < 6; ++j)
+      {
+        for(l = 0; l < 6; ++l) transfer[5][j] -= offset[l] * elementMatrix(l, j);
+        transfer[5][j] += offset[j];
+      }
+
+      memcpy(previous, cumulative, sizeof(cumulative));
+
+      for(i = 0; i < 6; ++i)
+      {
+        for(j = 0; j < 6; ++j)
+        {
+          product[i][j] = 0.0;
+          for(l = 0; l < 6; ++l) product[i][j] += cumulative[i][l] * transfer[l][j];
+        }
+      }
+      memcpy(cumulative, product, sizeof(cumulative));
+
+      if(k == last)
+      {
+        for(i = 0; i < 6; ++i)
+        {
+          fTransportTable[(n * 4 + 0) * 6 + i] = (1.0 - weight) * previous[i][0] + weight * cumulative[i][0];
+          fTransportTable[(n * 4 + 1) * 6 + i] = previous[i][1];
+          fTransportTable[(n * 4 + 2) * 6 + i] = (1.0 - weight) * previous[i][2] + weight * cumulative[i][2];
+          fTransportTable[(n * 4 + 3) * 6 + i] = previous[i][3];
+        }
+      }
+
+      // aperture check at the entrance and at the exit, as H_BeamParticle::stopped does
+
+      for(cell = 0; cell < numberOfCells; ++cell)
+      {
+        Double_t xExit = 0.0, yExit = 0.0;
+        for(l = 0; l < 6; ++l)
+        {
+          xExit += start[cell * 6 + l] * cumulative[l][0];
+          yExit += start[cell * 6 + l] * cumulative[l][2];
+        }
+        xExit *= URAD;
+        yExit *= URAD;
+
+        if(element->getAperture()->getType() != NONE && fAcceptanceTable[n * numberOfCells + cell])
+        {
+          inside = element->isInside(entrance[cell * 2 + 0], entrance[cell * 2 + 1]) && element->isInside(xExit, yExit);
+          if(!inside) fAcceptanceTable[n * numberOfCells + cell] = kFALSE;
+        }
+
+        entrance[cell * 2 + 0] = xExit;
+        entrance[cell * 2 + 1] = yExit;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t Hector::TransportWithTable(Double_t x, Double_t y, Double_t tx, Double_t ty, Double_t energy,
+  Double_t &xOut, Double_t &yOut, Double_t &txOut, Double_t &tyOut) const
+{
+  // returns kFALSE if the candidate is stopped by an aperture;
+  // the caller checks that the candidate lies inside the table
+
+  const Double_t eloss = BE - energy;
+  const Double_t u = eloss / (BE * fXiMax) * fXiBins;
+  const Int_t n = TMath::Min(Int_t(u), fXiBins - 1);
+  const Double_t w = u - n;
+  const Double_t theta = TMath::Hypot(tx, ty) / URAD;
+  const Double_t t = energy * energy * theta * theta;
+  Int_t it, ip, node;
+  Double_t phi, v[6], out[4];
+  Int_t i, k;
+
+  it = TMath::Min(Int_t(t / fTMax * fTBins), fTBins - 1);
+  phi = TMath::ATan2(ty, tx);
+  ip = TMath::Min(Int_t((phi + TMath::Pi()) / TMath::TwoPi() * fPhiBins), fPhiBins - 1);
+  node = (w < 0.5) ? n : n + 1;
+
+  if(!fAcceptanceTable[(node * fTBins + it) * fPhiBins + ip]) return kFALSE;
+
+  v[0] = x / URAD;
+  v[1] = TMath::Tan(tx / URAD);
+  v[2] = y / URAD;
+  v[3] = TMath::Tan(ty / URAD);
+  v[4] = relative_energy ? -eloss : energy;
+  v[5] = 1.0;
+
+  const Double_t *lower = &fTransportTable[n * 24];
+  const Double_t *upper = &fTransportTable[(n + 1) * 24];
+
+  for(k = 0; k < 4; ++k)
+  {
+    out[k] = 0.0;
+    for(i = 0; i < 6; ++i) out[k] += v[i] * ((1.0 - w) * lower[k * 6 + i] + w * upper[k * 6 + i]);
+  }
+
+  xOut = out[0] * URAD;
+  txOut = TMath::ATan(out[1]) * URAD;
+  yOut = out[2] * URAD;
+  tyOut = TMath::ATan(out[3]) * URAD;
+
+  return kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
 void Hector::Process()
 {
   Candidate *candidate, *mother;
   Double_t pz;
   Double_t x, y, z, tx, ty, theta;
   Double_t distance, time;
+  Double_t energy, eloss, xOut, yOut, txOut, tyOut;
 
   const Double_t c_light = 2.99792458E8;
 
@@ -140,6 +362,54 @@ void Hector::Process()
     distance = (fDistance - 1.0E-3 * candidatePosition.Z()) / TMath::Cos(theta);
     time = gRandom->Gaus((distance + 1.0E-3 * candidatePosition.T()) / c_light, fSigmaT);
 
+    // the table is built for the proton mass and charge,
+    // other particles are tracked through the beam line
+    if(fUseTransportTable && candidate->PID == 2212)
+    {
+      // same random sequence as H_BeamParticle::smearAng and smearE below
+      tx = gRandom->Gaus(tx, fSigmaX);
+      ty = gRandom->Gaus(ty, fSigmaY);
+      energy = gRandom->Gaus(candidateMomentum.E(), fSigmaE);
+      eloss = BE - energy;
+
+      if(eloss >= 0.0 && eloss < BE * fXiMax
+        && TMath::Power(energy * TMath::Hypot(tx, ty) / URAD, 2) < fTMax)
+      {
+        if(!TransportWithTable(x, y, tx, ty, energy, xOut, yOut, txOut, tyOut)) continue;
+
+        mother = candidate;
+        candidate = static_cast<Candidate *>(candidate->Clone());
+        candidate->Position.SetXYZT(xOut, yOut, fDistance, time);
+        candidate->Momentum.SetPxPyPzE(txOut, tyOut, 0.0, energy);
+        candidate->AddCandidate(mother);
+
+        fOutputArray->Add(candidate);
+        continue;
+      }
+
+      // outside the table, fall back to the full tracking with the same smearing
+      H_BeamParticle particle(candidate->Mass, candidate->Charge);
+      particle.set4Momentum(candidateMomentum.Px(), candidateMomentum.Py(),
+        candidateMomentum.Pz(), candidateMomentum.E());
+      particle.setPosition(x, y, tx, ty, z);
+      particle.setE(energy);
+
+      particle.computePath(fBeamLine);
+
+      if(particle.stopped(fBeamLine)) continue;
+
+      particle.propagate(fDistance);
+
+      mother = candidate;
+      candidate = static_cast<Candidate *>(candidate->Clone());
+      candidate->Position.SetXYZT(particle.getX(), particle.getY(), particle.getS(), time);
+      candidate->Momentum.SetPxPyPzE(particle.getTX(), particle.getTY(), 0.0, particle.getE());
+      candidate->AddCandidate(mother);
+
+      fOutputArray->Add(candidate);
+      continue;
+    }
+
     H_BeamParticle particle(candidate->Mass, candidate->Charge);
     //    particle.set4Momentum(candidateMomentum);
     particle.set4Momentum(candidateMomentum.Px(), candidateMomentum.Py(),
@@ -23,12 +23,22 @@
  *
  *  Propagates candidates using Hector library.
  *
+ *  With UseTransportTable enabled, the beamline is linearised at Init():
+ *  for a grid of energy losses the element-by-element transport is folded
+ *  into one affine map from the interaction point to Distance, and the
+ *  aperture acceptance is tabulated in (xi, t, phi). Each candidate is then
+ *  transported with one small matrix product and one table lookup. The
+ *  acceptance table assumes a proton starting on the beam axis; candidates
+ *  outside the tabulated xi range go through the full Hector tracking.
+ *
  *  \author P. Demin - UCL, Louvain-la-Neuve
  *
  */
 
 #include "classes/DelphesModule.h"
 
+#include <vector>
+
 class TIterator;
 class TObjArray;
 class H_BeamLine;
@@ -44,6 +54,9 @@ public:
   void Finish();
 
 private:
+  void BuildTransportTable();
+  Bool_t TransportWithTable(Double_t x, Double_t y, Double_t tx, Double_t ty, Double_t energy, Double_t &xOut, Double_t &yOut, Double_t &txOut, Double_t &tyOut) const;
+
   Int_t fDirection;
 
   Double_t fBeamLineLength, fDistance;
@@ -53,6 +66,14 @@ private:
 
   H_BeamLine *fBeamLine;
 
+  Bool_t fUseTransportTable;
+
+  Int_t fXiBins, fTBins, fPhiBins;
+  Double_t fXiMax, fTMax;
+
+  std::vector<Double_t> fTransportTable; //!
+  std::vector<Bool_t> fAcceptanceTable; //!
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
@@ -30,6 +30,7 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
+#include "classes/DelphesFormulaGrid.h"
 
 #include "ExRootAnalysis/ExRootClassifier.h"
 #include "ExRootAnalysis/ExRootFilter.h"
@@ -52,8 +53,12 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
+static const Int_t kMaxDensePID = 10000;
+
+//------------------------------------------------------------------------------
+
 IdentificationMap::IdentificationMap() :
-  fItInputArray(0)
+  fCompileFormulas(kFALSE), fMaxPID(0), fItInputArray(0)
 {
 }
 
@@ -68,10 +73,18 @@ IdentificationMap::~IdentificationMap()
 void IdentificationMap::Init()
 {
   TMisIDMap::iterator itEfficiencyMap;
+  pair<TMisIDMap::iterator, TMisIDMap::iterator> range;
+  map<DelphesFormula *, DelphesFormulaGrid *> grids;
+  map<Int_t, Int_t> slots;
   ExRootConfParam param;
   DelphesFormula *formula;
+  DelphesFormulaGrid *grid;
   Int_t i, size, pdg;
 
+  // switch to evaluate the formulas on piecewise-constant (pt, eta) grids,
+  // with the formulas of each PID looked up in a dense table
+  fCompileFormulas = GetBool("CompileFormulas", false);
+
   // read efficiency formulas
   param = GetParam("EfficiencyFormula");
   size = param.GetSize();
@@ -83,6 +96,13 @@ void IdentificationMap::Init()
     formula->Compile(param[i * 3 + 2].GetString());
     pdg = param[i * 3].GetInt();
     fEfficiencyMap.insert(make_pair(pdg, make_pair(param[i * 3 + 1].GetInt(), formula)));
+
+    if(fCompileFormulas)
+    {
+      grid = new DelphesFormulaGrid;
+      grid->Build(formula, param[i * 3 + 2].GetString());
+      grids[formula] = grid;
+    }
   }
 
   // set default efficiency formula
@@ -93,6 +113,49 @@ void IdentificationMap::Init()
     formula->Compile("1.0");
 
     fEfficiencyMap.insert(make_pair(0, make_pair(0, formula)));
+
+    if(fCompileFormulas)
+    {
+      grid = new DelphesFormulaGrid;
+      grid->Build(formula, "1.0");
+      grids[formula] = grid;
+    }
+  }
+
+  if(fCompileFormulas)
+  {
+    // one slot per PID of the map, with the entries of this PID in the map order
+    fSlotBegin.clear();
+    fSlotPID.clear();
+    fSlotGrid.clear();
+    fMaxPID = 0;
+    for(itEfficiencyMap = fEfficiencyMap.begin(); itEfficiencyMap != fEfficiencyMap.end(); itEfficiencyMap = range.second)
+    {
+      range = fEfficiencyMap.equal_range(itEfficiencyMap->first);
+      slots[range.first->first] = fSlotBegin.size();
+      fSlotBegin.push_back(fSlotPID.size());
+      for(itEfficiencyMap = range.first; itEfficiencyMap != range.second; ++itEfficiencyMap)
+      {
+        fSlotPID.push_back((itEfficiencyMap->second).first);
+        fSlotGrid.push_back(grids[(itEfficiencyMap->second).second]);
+      }
+      fMaxPID = max(fMaxPID, TMath::Abs(range.first->first));
+    }
+    fSlotBegin.push_back(fSlotPID.size());
+
+    // same lookup order as in Process: PID, then -PID, then 0,
+    // larger PIDs are looked up in the map
+    fMaxPID = min(fMaxPID, kMaxDensePID);
+    fSlotOfPID.resize(2 * fMaxPID + 1);
+    for(pdg = -fMaxPID; pdg <= fMaxPID; ++pdg)
+    {
+      if(slots.count(pdg))
+        fSlotOfPID[pdg + fMaxPID] = slots[pdg];
+      else if(slots.count(-pdg))
+        fSlotOfPID[pdg + fMaxPID] = slots[-pdg];
+      else
+        fSlotOfPID[pdg + fMaxPID] = slots[0];
+    }
   }
 
   // import input array
@@ -118,6 +181,13 @@ void IdentificationMap::Finish()
     formula = (itEfficiencyMap->second).second;
     if(formula) delete formula;
   }
+
+  vector<DelphesFormulaGrid *>::iterator itSlotGrid;
+  for(itSlotGrid = fSlotGrid.begin(); itSlotGrid != fSlotGrid.end(); ++itSlotGrid)
+  {
+    delete *itSlotGrid;
+  }
+  fSlotGrid.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -129,7 +199,7 @@ void IdentificationMap::Process()
   TMisIDMap::iterator itEfficiencyMap;
   pair<TMisIDMap::iterator, TMisIDMap::iterator> range;
   DelphesFormula *formula;
-  Int_t pdgCodeIn, pdgCodeOut, charge;
+  Int_t pdgCodeIn, pdgCodeOut, charge, slot, i;
 
   Double_t p, r, total;
 
@@ -146,6 +216,33 @@ void IdentificationMap::Process()
     pdgCodeIn = candidate->PID;
     charge = candidate->Charge;
 
+    if(fCompileFormulas && TMath::Abs(pdgCodeIn) <= fMaxPID)
+    {
+      // precomputed slot of this PID
+      slot = fSlotOfPID[pdgCodeIn + fMaxPID];
+
+      r = gRandom->Uniform();
+      total = 0.0;
+
+      for(i = fSlotBegin[slot]; i < fSlotBegin[slot + 1]; ++i)
+      {
+        p = fSlotGrid[i]->Eval(pt, eta, phi, e);
+
+        if(total <= r && r < total + p)
+        {
+          // change PID of particle
+          candidate = static_cast<Candidate *>(candidate->Clone());
+          if(fSlotPID[i] != 0) candidate->PID = charge * fSlotPID[i];
+          fOutputArray->Add(candidate);
+          break;
+        }
+
+        total += p;
+      }
+
+      continue;
+    }
+
     // first check that PID of this particle is specified in the map
     // otherwise, look for PID = 0
 
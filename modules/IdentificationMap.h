@@ -30,9 +30,13 @@
 
 #include "classes/DelphesModule.h"
 
+#include <map>
+#include <vector>
+
 class TIterator;
 class TObjArray;
 class DelphesFormula;
+class DelphesFormulaGrid;
 
 class IdentificationMap: public DelphesModule
 {
@@ -49,6 +53,16 @@ private:
 
   TMisIDMap fEfficiencyMap; //!
 
+  Bool_t fCompileFormulas; //!
+
+  // compiled mode: slot of each PID in [-fMaxPID, fMaxPID], the entries of slot i
+  // (output PID and formula grid) are fSlotBegin[i] to fSlotBegin[i + 1] - 1
+  Int_t fMaxPID; //!
+  std::vector<Int_t> fSlotOfPID; //!
+  std::vector<Int_t> fSlotBegin; //!
+  std::vector<Int_t> fSlotPID; //!
+  std::vector<DelphesFormulaGrid *> fSlotGrid; //!
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
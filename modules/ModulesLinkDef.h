@@ -83,6 +83,7 @@
 #include "modules/LLPFilter.h"
 #include "modules/CscClusterEfficiency.h"
 #include "modules/CscClusterId.h"
+#include "modules/EventFilter.h"
 
 #ifdef __CINT__
 
@@ -148,5 +149,6 @@
 #pragma link C++ class LLPFilter+;
 #pragma link C++ class CscClusterEfficiency+;
 #pragma link C++ class CscClusterId+;
+#pragma link C++ class EventFilter+;
 
 #endif
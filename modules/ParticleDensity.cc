@@ -20,6 +20,7 @@
  *
  *  This module calculates the particle multiplicity density in eta-phi bins.
  *  It then assigns the value to the candidates according to the candidate eta.
+ *  The density map is also exported, so that other modules can query it.
  *
  *  \author R. Preghenella - INFN, Bologna
  *
@@ -28,6 +29,7 @@
 #include "modules/ParticleDensity.h"
 
 #include "classes/DelphesClasses.h"
+#include "classes/DelphesDensityGrid.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
 
@@ -41,7 +43,6 @@
 #include "TObjArray.h"
 #include "TRandom3.h"
 #include "TString.h"
-#include "TH2F.h"
 
 #include <algorithm>
 #include <iostream>
@@ -53,7 +54,7 @@ using namespace std;
 //------------------------------------------------------------------------------
 
 ParticleDensity::ParticleDensity() :
-  fItInputArray(0)
+  fItInputArray(0), fGrid(0)
 {}
 
 //------------------------------------------------------------------------------
@@ -74,28 +75,29 @@ void ParticleDensity::Init()
   // create output array(s)
 
   fOutputArray = ExportArray(GetString("OutputArray", "tracks"));
+  fDensityMapOutputArray = ExportArray(GetString("DensityMapOutputArray", "densityMap"));
 
-  // create multiplicity histogram
+  // create multiplicity grid
 
   ExRootConfParam paramEta = GetParam("EtaBins");
   const Long_t sizeEta = paramEta.GetSize();
-  Int_t nbinsEta = sizeEta - 1;
-  Float_t binsEta[sizeEta];
+  vector<Double_t> binsEta(sizeEta);
   for (Int_t i = 0; i < sizeEta; ++i) {
     binsEta[i] = paramEta[i].GetDouble();
   }
-  
+
   ExRootConfParam paramPhi = GetParam("PhiBins");
   const Long_t sizePhi = paramPhi.GetSize();
-  Int_t nbinsPhi = sizePhi - 1;
-  Float_t binsPhi[sizePhi];
+  vector<Double_t> binsPhi(sizePhi);
   for (Int_t i = 0; i < sizePhi; ++i) {
     binsPhi[i] = paramPhi[i].GetDouble();
   }
-  
-  fHisto = new TH2F("hParticleDensity", ";#eta;#varphi;d^{2}N/d#etad#varphi", nbinsEta, binsEta, nbinsPhi, binsPhi);
 
   fUseMomentumVector = GetBool("UseMomentumVector", false);
+
+  fGrid = new DelphesDensityGrid;
+  fGrid->SetBins(binsEta, binsPhi);
+  fGrid->SetUseMomentumVector(fUseMomentumVector);
 }
 
 //------------------------------------------------------------------------------
@@ -103,7 +105,7 @@ void ParticleDensity::Init()
 void ParticleDensity::Finish()
 {
   if(fItInputArray) delete fItInputArray;
-  if (fHisto) delete fHisto;
+  if (fGrid) delete fGrid;
 }
 
 //------------------------------------------------------------------------------
@@ -111,34 +113,27 @@ void ParticleDensity::Finish()
 void ParticleDensity::Process()
 {
   Candidate *candidate;
-  fHisto->Reset();
-  
-  // loop over all input candidates to fill histogram
-  fItInputArray->Reset();
-  while((candidate = static_cast<Candidate *>(fItInputArray->Next()))) {
-    if (fUseMomentumVector) fHisto->Fill(candidate->Momentum.Eta(), candidate->Momentum.Phi());
-    else                    fHisto->Fill(candidate->Position.Eta(), candidate->Position.Phi());
+  Int_t i, size;
+
+  fGrid->Reset();
+
+  // loop over all input candidates to fill the grid, keeping the bin of each candidate
+  size = fInputArray->GetEntriesFast();
+  fBins.resize(size);
+  for(i = 0; i < size; ++i) {
+    candidate = static_cast<Candidate *>(fInputArray->At(i));
+    fBins[i] = fGrid->FindBin(candidate);
+    fGrid->Fill(fBins[i]);
   }
 
-  // normalise by bin width
-  fHisto->Scale(1., "width");
-  
-  // loop over all input candidates to assign multiplicity
-  fItInputArray->Reset();
-  while((candidate = static_cast<Candidate *>(fItInputArray->Next()))) {
-    Int_t ieta, iphi;
-    if (fUseMomentumVector) {
-      ieta = fHisto->GetXaxis()->FindBin(candidate->Momentum.Eta());
-      iphi = fHisto->GetYaxis()->FindBin(candidate->Momentum.Phi());
-    } else {
-      ieta = fHisto->GetXaxis()->FindBin(candidate->Position.Eta());
-      iphi = fHisto->GetYaxis()->FindBin(candidate->Position.Phi());
-    }
-    candidate->ParticleDensity = fHisto->GetBinContent(ieta, iphi);
+  // loop over all input candidates to assign multiplicity, normalised by bin width
+  for(i = 0; i < size; ++i) {
+    candidate = static_cast<Candidate *>(fInputArray->At(i));
+    candidate->ParticleDensity = fGrid->GetDensity(fBins[i]);
     fOutputArray->Add(candidate);
   }
 
-  
+  fDensityMapOutputArray->Add(fGrid);
 }
 
 //------------------------------------------------------------------------------
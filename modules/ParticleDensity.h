@@ -23,6 +23,7 @@
  *
  *  This module calculates the particle multiplicity density in eta-phi bins.
  *  It then assigns the value to the candidates according to the candidate eta.
+ *  The density map is also exported, so that other modules can query it.
  *
  *  \author R. Preghenella - INFN, Bologna
  *
@@ -30,10 +31,10 @@
 
 #include "classes/DelphesModule.h"
 
-#include <deque>
+#include <vector>
 
 class TObjArray;
-class TH2F;
+class DelphesDensityGrid;
 
 class ParticleDensity: public DelphesModule
 {
@@ -52,11 +53,14 @@ private:
   const TObjArray *fInputArray; //!
 
   TObjArray *fOutputArray; //!
+  TObjArray *fDensityMapOutputArray; //!
 
   Bool_t fUseMomentumVector; // !
-  TH2F *fHisto; //!
-  
-  ClassDef(ParticleDensity, 1)
+  DelphesDensityGrid *fGrid; //!
+
+  std::vector<Int_t> fBins; //!
+
+  ClassDef(ParticleDensity, 2)
 };
 
 #endif
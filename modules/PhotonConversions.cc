@@ -83,6 +83,25 @@ void PhotonConversions::Init()
 
   fConversionMap->Compile(GetString("ConversionMap", "0.0"));
 
+  // precompute the cumulative conversion probability along (eta, phi) rays
+  // so that prompt photons need one random number and one table search
+
+  fTable.clear();
+  fTableOffset.clear();
+
+  if(GetBool("UseConversionTable", false))
+  {
+    fTableEtaBins = GetInt("TableEtaBins", 100);
+    fTablePhiBins = GetInt("TablePhiBins", 32);
+
+    if(fTableEtaBins <= 0 || fTablePhiBins <= 0)
+    {
+      throw runtime_error("TableEtaBins and TablePhiBins must be positive");
+    }
+
+    BuildConversionTable();
+  }
+
   // import array with output from filter/classifier module
 
   fInputArray = ImportArray(GetString("InputArray", "Delphes/stableParticles"));
@@ -104,6 +123,94 @@ void PhotonConversions::Finish()
 
 //------------------------------------------------------------------------------
 
+void PhotonConversions::BuildConversionTable()
+{
+  Int_t i, j, k, nsteps;
+  Double_t eta, phi, dx, dy, dz, pt2, t, t3, t4, s;
+  Double_t x_i, y_i, z_i, sum;
+
+  fTableOffset.resize(fTableEtaBins * fTablePhiBins + 1);
+
+  for(i = 0; i < fTableEtaBins; ++i)
+  {
+    eta = fEtaMin + (i + 0.5) * (fEtaMax - fEtaMin) / fTableEtaBins;
+
+    for(j = 0; j < fTablePhiBins; ++j)
+    {
+      phi = -TMath::Pi() + (j + 0.5) * 2.0 * TMath::Pi() / fTablePhiBins;
+
+      fTableOffset[i * fTablePhiBins + j] = fTable.size();
+
+      // unit direction from the origin, path length as in Process
+      dx = TMath::Cos(phi) / TMath::CosH(eta);
+      dy = TMath::Sin(phi) / TMath::CosH(eta);
+      dz = TMath::TanH(eta);
+
+      pt2 = dx * dx + dy * dy;
+      t = TMath::Sqrt(fRadius2 / pt2);
+
+      if(TMath::Abs(dz * t) > fHalfLength)
+      {
+        t3 = +fHalfLength / dz;
+        t4 = -fHalfLength / dz;
+        t = (t3 < 0.0) ? t4 : t3;
+      }
+
+      nsteps = Int_t(t / fStep);
+
+      // survival probability after k steps is exp(-sum)
+      sum = 0.0;
+      for(k = 0; k < nsteps; ++k)
+      {
+        s = (k + 1) * t / nsteps;
+        x_i = dx * s;
+        y_i = dy * s;
+        z_i = dz * s;
+
+        sum += 7.0 / 9.0 * fStep * fConversionMap->Eval(TMath::Sqrt(x_i * x_i + y_i * y_i), TMath::ATan2(y_i, x_i), z_i);
+        fTable.push_back(sum);
+      }
+    }
+  }
+
+  fTableOffset[fTableEtaBins * fTablePhiBins] = fTable.size();
+}
+
+//------------------------------------------------------------------------------
+
+Int_t PhotonConversions::SampleConversionStep(Double_t eta, Double_t phi, Int_t nsteps)
+{
+  Int_t i, j, bin;
+  Double_t u;
+  vector<Double_t>::const_iterator first, last, itTable;
+
+  i = Int_t((eta - fEtaMin) / (fEtaMax - fEtaMin) * fTableEtaBins);
+  j = Int_t((phi + TMath::Pi()) / (2.0 * TMath::Pi()) * fTablePhiBins);
+
+  i = TMath::Max(0, TMath::Min(i, fTableEtaBins - 1));
+  j = TMath::Max(0, TMath::Min(j, fTablePhiBins - 1));
+
+  bin = i * fTablePhiBins + j;
+
+  // the ray must have as many steps as the photon path,
+  // returns -1 otherwise and the photon is stepped through the map
+  if(fTableOffset[bin + 1] - fTableOffset[bin] != nsteps) return -1;
+
+  first = fTable.begin() + fTableOffset[bin];
+  last = fTable.begin() + fTableOffset[bin + 1];
+
+  // the photon converts at the first step where the cumulative
+  // conversion rate exceeds -log(u), returns nsteps if it does not
+  u = gRandom->Uniform();
+  if(u <= 0.0) return nsteps;
+
+  itTable = lower_bound(first, last, -TMath::Log(u));
+
+  return itTable == last ? nsteps : Int_t(itTable - first);
+}
+
+//------------------------------------------------------------------------------
+
 void PhotonConversions::Process()
 {
   Candidate *candidate, *ep, *em;
@@ -191,56 +298,79 @@ void PhotonConversions::Process()
 
       converted = false;
 
-      for(i = 0; i < nsteps; ++i)
+      // prompt photon, use the precomputed ray through its direction
+      // if it has the same number of steps as the photon path
+      i = -1;
+      if(!fTable.empty() && x * x + y * y + z * z < 0.25 * fStep * fStep)
       {
-        x_i += px * dt;
-        y_i += py * dt;
-        z_i += pz * dt;
-        pos_i.SetXYZ(x_i, y_i, z_i);
+        i = SampleConversionStep(eta, phi, nsteps);
+      }
 
-        // convert photon position into cylindrical coordinates, cylindrical r,phi,z !!
+      if(i >= 0)
+      {
+        if(i < nsteps)
+        {
+          converted = true;
+          x_i = x + px * dt * (i + 1);
+          y_i = y + py * dt * (i + 1);
+          z_i = z + pz * dt * (i + 1);
+        }
+      }
+      else
+      {
+        for(i = 0; i < nsteps; ++i)
+        {
+          x_i += px * dt;
+          y_i += py * dt;
+          z_i += pz * dt;
+          pos_i.SetXYZ(x_i, y_i, z_i);
 
-        r_i = TMath::Sqrt(x_i * x_i + y_i * y_i);
-        phi_i = pos_i.Phi();
+          // convert photon position into cylindrical coordinates, cylindrical r,phi,z !!
 
-        // read conversion rate/meter from card
-        rate = fConversionMap->Eval(r_i, phi_i, z_i);
+          r_i = TMath::Sqrt(x_i * x_i + y_i * y_i);
+          phi_i = pos_i.Phi();
 
-        // convert into conversion probability
-        p_conv = 1 - TMath::Exp(-7.0 / 9.0 * fStep * rate);
+          // read conversion rate/meter from card
+          rate = fConversionMap->Eval(r_i, phi_i, z_i);
 
-        // case conversion occurs
-        if(gRandom->Uniform() < p_conv)
-        {
-          converted = true;
+          // convert into conversion probability
+          p_conv = 1 - TMath::Exp(-7.0 / 9.0 * fStep * rate);
 
-          // generate x1 and x2, the fraction of the photon energy taken resp. by e+ and e-
-          x1 = fDecayXsec->GetRandom();
-          x2 = 1 - x1;
+          // case conversion occurs
+          if(gRandom->Uniform() < p_conv)
+          {
+            converted = true;
+            break;
+          }
+        }
+      }
 
-          ep = static_cast<Candidate *>(candidate->Clone());
-          em = static_cast<Candidate *>(candidate->Clone());
+      if(converted)
+      {
+        // generate x1 and x2, the fraction of the photon energy taken resp. by e+ and e-
+        x1 = fDecayXsec->GetRandom();
+        x2 = 1 - x1;
 
-          ep->Position.SetXYZT(x_i * 1.0E3, y_i * 1.0E3, z_i * 1.0E3, candidatePosition.T() + nsteps * dt * e * 1.0E3);
-          em->Position.SetXYZT(x_i * 1.0E3, y_i * 1.0E3, z_i * 1.0E3, candidatePosition.T() + nsteps * dt * e * 1.0E3);
+        ep = static_cast<Candidate *>(candidate->Clone());
+        em = static_cast<Candidate *>(candidate->Clone());
 
-          ep->Momentum.SetPtEtaPhiE(x1 * pt, eta, phi, x1 * e);
-          em->Momentum.SetPtEtaPhiE(x2 * pt, eta, phi, x2 * e);
+        ep->Position.SetXYZT(x_i * 1.0E3, y_i * 1.0E3, z_i * 1.0E3, candidatePosition.T() + nsteps * dt * e * 1.0E3);
+        em->Position.SetXYZT(x_i * 1.0E3, y_i * 1.0E3, z_i * 1.0E3, candidatePosition.T() + nsteps * dt * e * 1.0E3);
 
-          ep->PID = -11;
-          em->PID = 11;
+        ep->Momentum.SetPtEtaPhiE(x1 * pt, eta, phi, x1 * e);
+        em->Momentum.SetPtEtaPhiE(x2 * pt, eta, phi, x2 * e);
 
-          ep->Charge = 1.0;
-          em->Charge = -1.0;
+        ep->PID = -11;
+        em->PID = 11;
 
-          ep->IsFromConversion = 1;
-          em->IsFromConversion = 1;
+        ep->Charge = 1.0;
+        em->Charge = -1.0;
 
-          fOutputArray->Add(em);
-          fOutputArray->Add(ep);
+        ep->IsFromConversion = 1;
+        em->IsFromConversion = 1;
 
-          break;
-        }
+        fOutputArray->Add(em);
+        fOutputArray->Add(ep);
       }
       if(!converted) fOutputArray->Add(candidate);
     }
@@ -29,6 +29,8 @@
 
 #include "classes/DelphesModule.h"
 
+#include <vector>
+
 class TClonesArray;
 class TIterator;
 class DelphesCylindricalFormula;
@@ -45,6 +47,9 @@ public:
   void Finish();
 
 private:
+  void BuildConversionTable();
+  Int_t SampleConversionStep(Double_t eta, Double_t phi, Int_t nsteps);
+
   Double_t fRadius, fRadius2, fHalfLength;
   Double_t fEtaMin, fEtaMax;
 
@@ -60,6 +65,11 @@ private:
 
   Double_t fStep;
 
+  Int_t fTableEtaBins, fTablePhiBins;
+
+  std::vector<Double_t> fTable; //!
+  std::vector<Int_t> fTableOffset; //!
+
   ClassDef(PhotonConversions, 1)
 };
 
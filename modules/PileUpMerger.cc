@@ -20,6 +20,12 @@
  *
  *  Merges particles from pile-up sample into event
  *
+ *  With PreloadLibrary set, the pile-up library is decoded once into
+ *  memory as arrays of particle properties, the rotation and shifts are
+ *  applied to each drawn event in a single loop.
+ *  Particles failing the PreCutPTMin/PreCutEtaMax pre-selection are not
+ *  turned into candidates and do not enter the pile-up vertex.
+ *
  *  \author M. Selvaggi - UCL, Louvain-la-Neuve
  *
  */
@@ -53,7 +59,7 @@ using namespace std;
 //------------------------------------------------------------------------------
 
 PileUpMerger::PileUpMerger() :
-  fFunction(0), fReader(0), fItInputArray(0)
+  fFunction(0), fReader(0), fPreload(kFALSE), fPreCutPTMin(0.0), fPreCutEtaMax(0.0), fItInputArray(0)
 {
   fFunction = new DelphesTF2;
 }
@@ -91,6 +97,16 @@ void PileUpMerger::Init()
   fileName = GetString("PileUpFile", "MinBias.pileup");
   fReader = new DelphesPileUpReader(fileName);
 
+  // keep the whole library in memory (optional)
+  fPreload = GetBool("PreloadLibrary", false);
+
+  // do not create candidates for particles below PreCutPTMin or
+  // above PreCutEtaMax (not applied if not positive)
+  fPreCutPTMin = GetDouble("PreCutPTMin", 0.0);
+  fPreCutEtaMax = GetDouble("PreCutEtaMax", 0.0);
+
+  if(fPreload) PreloadLibrary();
+
   // import input array
   fInputArray = ImportArray(GetString("InputArray", "Delphes/stableParticles"));
   fItInputArray = fInputArray->MakeIterator();
@@ -109,6 +125,98 @@ void PileUpMerger::Finish()
 
 //------------------------------------------------------------------------------
 
+void PileUpMerger::PreloadLibrary()
+{
+  TDatabasePDG *pdg = TDatabasePDG::Instance();
+  TParticlePDG *pdgParticle;
+  Int_t pid;
+  Float_t x, y, z, t, px, py, pz, e;
+  Long64_t allEntries, entry;
+
+  allEntries = fReader->GetEntries();
+
+  fOffsets.clear();
+  fOffsets.reserve(allEntries + 1);
+  fOffsets.push_back(0);
+
+  for(entry = 0; entry < allEntries; ++entry)
+  {
+    fReader->ReadEntry(entry);
+    while(fReader->ReadParticle(pid, x, y, z, t, px, py, pz, e))
+    {
+      pdgParticle = pdg->GetParticle(pid);
+
+      fPID.push_back(pid);
+      fCharge.push_back(pdgParticle ? Int_t(pdgParticle->Charge() / 3.0) : -999);
+      fMass.push_back(pdgParticle ? pdgParticle->Mass() : -999.9);
+
+      fX.push_back(x - fInputBeamSpotX);
+      fY.push_back(y - fInputBeamSpotY);
+      fZ.push_back(z);
+      fT.push_back(t);
+      fPX.push_back(px);
+      fPY.push_back(py);
+      fPZ.push_back(pz);
+      fE.push_back(e);
+    }
+    fOffsets.push_back(fPID.size());
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void PileUpMerger::TransformEvent(Long64_t begin, Int_t size, Double_t dphi)
+{
+  const Float_t *x, *y, *px, *py;
+  Double_t *eventX, *eventY, *eventPX, *eventPY;
+  Double_t c = TMath::Cos(dphi), s = TMath::Sin(dphi);
+  Int_t i;
+
+  if(size <= 0) return;
+
+  if(Int_t(fEventX.size()) < size)
+  {
+    fEventX.resize(size);
+    fEventY.resize(size);
+    fEventPX.resize(size);
+    fEventPY.resize(size);
+  }
+
+  x = &fX[begin];
+  y = &fY[begin];
+  px = &fPX[begin];
+  py = &fPY[begin];
+
+  eventX = &fEventX[0];
+  eventY = &fEventY[0];
+  eventPX = &fEventPX[0];
+  eventPY = &fEventPY[0];
+
+  // same operations as TLorentzVector::RotateZ followed by the output beam spot shift
+  for(i = 0; i < size; ++i)
+  {
+    eventPX[i] = c * px[i] - s * py[i];
+    eventPY[i] = s * px[i] + c * py[i];
+    eventX[i] = c * x[i] - s * y[i] + fOutputBeamSpotX;
+    eventY[i] = s * x[i] + c * y[i] + fOutputBeamSpotY;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t PileUpMerger::PassPreCut(Double_t px, Double_t py, Double_t pz) const
+{
+  // the rotation around the beam axis does not change pt and eta
+  Double_t pt = TMath::Hypot(px, py);
+
+  if(pt < fPreCutPTMin) return kFALSE;
+  if(fPreCutEtaMax > 0.0 && (pt <= 0.0 || TMath::Abs(TMath::ASinH(pz / pt)) > fPreCutEtaMax)) return kFALSE;
+
+  return kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
 void PileUpMerger::Process()
 {
   TDatabasePDG *pdg = TDatabasePDG::Instance();
@@ -117,8 +225,8 @@ void PileUpMerger::Process()
   Float_t x, y, z, t, vx, vy;
   Float_t px, py, pz, e, pt;
   Double_t dz, dphi, dt, sumpt2, dz0, dt0;
-  Int_t numberOfEvents, event, numberOfParticles;
-  Long64_t allEntries, entry;
+  Int_t numberOfEvents, event, numberOfParticles, i, size;
+  Long64_t allEntries, entry, begin;
   Candidate *candidate, *vertex;
   DelphesFactory *factory;
 
@@ -210,7 +318,7 @@ void PileUpMerger::Process()
     break;
   }
 
-  allEntries = fReader->GetEntries();
+  allEntries = fPreload ? Long64_t(fOffsets.size()) - 1 : fReader->GetEntries();
 
   for(event = 0; event < numberOfEvents; ++event)
   {
@@ -219,7 +327,7 @@ void PileUpMerger::Process()
       entry = TMath::Nint(gRandom->Rndm() * allEntries);
     } while(entry >= allEntries);
 
-    fReader->ReadEntry(entry);
+    if(!fPreload) fReader->ReadEntry(entry);
 
     // --- Pile-up vertex smearing
 
@@ -239,8 +347,56 @@ void PileUpMerger::Process()
     //factory = GetFactory();
     vertex = factory->NewCandidate();
 
-    while(fReader->ReadParticle(pid, x, y, z, t, px, py, pz, e))
+    if(fPreload)
+    {
+      begin = fOffsets[entry];
+      size = fOffsets[entry + 1] - begin;
+
+      TransformEvent(begin, size, dphi);
+
+      for(i = 0; i < size; ++i)
+      {
+        if(!PassPreCut(fEventPX[i], fEventPY[i], fPZ[begin + i])) continue;
+
+        vx += fEventX[i];
+        vy += fEventY[i];
+
+        pt = TMath::Hypot(fEventPX[i], fEventPY[i]);
+
+        ++numberOfParticles;
+        if(TMath::Abs(fCharge[begin + i]) > 1.0E-9)
+        {
+          nch++;
+          sumpt2 += pt * pt;
+        }
+
+        candidate = factory->NewCandidate();
+
+        candidate->PID = fPID[begin + i];
+
+        candidate->Status = 1;
+
+        candidate->Charge = fCharge[begin + i];
+        candidate->Mass = fMass[begin + i];
+
+        candidate->IsPU = 1;
+
+        candidate->Momentum.SetPxPyPzE(fEventPX[i], fEventPY[i], fPZ[begin + i], fE[begin + i]);
+        candidate->Position.SetXYZT(fEventX[i], fEventY[i], fZ[begin + i] + dz, fT[begin + i] + dt);
+
+        if(TMath::Abs(candidate->Charge) > 1.0E-9)
+        {
+          vertex->AddCandidate(candidate);
+        }
+
+        fParticleOutputArray->Add(candidate);
+      }
+    }
+
+    while(!fPreload && fReader->ReadParticle(pid, x, y, z, t, px, py, pz, e))
     {
+      if(!PassPreCut(px, py, pz)) continue;
+
       candidate = factory->NewCandidate();
 
       candidate->PID = pid;
@@ -23,12 +23,20 @@
  *
  *  Merges particles from pile-up sample into event
  *
+ *  With PreloadLibrary set, the pile-up library is decoded once into
+ *  memory as arrays of particle properties, the rotation and shifts are
+ *  applied to each drawn event in a single loop.
+ *  Particles failing the PreCutPTMin/PreCutEtaMax pre-selection are not
+ *  turned into candidates and do not enter the pile-up vertex.
+ *
  *  \author M. Selvaggi - UCL, Louvain-la-Neuve
  *
  */
 
 #include "classes/DelphesModule.h"
 
+#include <vector>
+
 class TObjArray;
 class DelphesPileUpReader;
 class DelphesTF2;
@@ -59,6 +67,24 @@ private:
 
   DelphesPileUpReader *fReader; //!
 
+  void PreloadLibrary();
+  void TransformEvent(Long64_t begin, Int_t size, Double_t dphi);
+  Bool_t PassPreCut(Double_t px, Double_t py, Double_t pz) const;
+
+  Bool_t fPreload;
+  Double_t fPreCutPTMin;
+  Double_t fPreCutEtaMax;
+
+  // pile-up library decoded in memory, particles of entry i are stored
+  // between fOffsets[i] and fOffsets[i + 1]
+  std::vector<Long64_t> fOffsets; //!
+  std::vector<Int_t> fPID, fCharge; //!
+  std::vector<Double_t> fMass; //!
+  std::vector<Float_t> fX, fY, fZ, fT, fPX, fPY, fPZ, fE; //!
+
+  // rotated and shifted coordinates of the current pile-up event
+  std::vector<Double_t> fEventX, fEventY, fEventPX, fEventPY; //!
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
@@ -66,7 +92,7 @@ private:
   TObjArray *fParticleOutputArray; //!
   TObjArray *fVertexOutputArray; //!
 
-  ClassDef(PileUpMerger, 1)
+  ClassDef(PileUpMerger, 2)
 };
 
 #endif
@@ -20,6 +20,12 @@
  *
  *  Merges particles from pile-up sample into event
  *
+ *  With NumberOfThreads > 0, minimum-bias events are generated ahead of time
+ *  by independently seeded Pythia8 instances running on background threads,
+ *  and stored in a bounded ring of events that Process consumes.
+ *  With RecycleFile set, the merged pile-up events are also written
+ *  to a pile-up library that can be read back by PileUpMerger.
+ *
  *  \author M. Selvaggi - UCL, Louvain-la-Neuve
  *
  */
@@ -29,6 +35,7 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesPileUpReader.h"
+#include "classes/DelphesPileUpWriter.h"
 #include "classes/DelphesTF2.h"
 
 #include "ExRootAnalysis/ExRootClassifier.h"
@@ -46,16 +53,136 @@
 #include "TString.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <random>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
+namespace
+{
+// compact copy of the particles kept from a minimum-bias event
+struct TPileUpParticle
+{
+  Int_t pid;
+  Float_t x, y, z, t;
+  Float_t px, py, pz, e;
+};
+
+struct TPileUpEvent
+{
+  Int_t size; // number of entries in the Pythia8 event record
+  vector<TPileUpParticle> particles;
+};
+
+void FillPileUpEvent(Pythia8::Pythia *pythia, Double_t ptMin, TPileUpEvent &event)
+{
+  TPileUpParticle particle;
+  Int_t i;
+
+  event.size = pythia->event.size();
+  event.particles.clear();
+  for(i = 1; i < event.size; ++i)
+  {
+    Pythia8::Particle &entry = pythia->event[i];
+
+    if(entry.statusHepMC() != 1 || !entry.isVisible() || entry.pT() <= ptMin) continue;
+
+    particle.pid = entry.id();
+    particle.px = entry.px();
+    particle.py = entry.py();
+    particle.pz = entry.pz();
+    particle.e = entry.e();
+    particle.x = entry.xProd();
+    particle.y = entry.yProd();
+    particle.z = entry.zProd();
+    particle.t = entry.tProd();
+
+    event.particles.push_back(particle);
+  }
+}
+
+// Pythia8 seed of a pool instance, hashed from (seed, instance) with splitmix64
+// so that different values of RandomSeed share no stream,
+// the result is in the range 1..900000000 accepted by Random:seed
+Int_t GetInstanceSeed(ULong64_t seed, Int_t instance)
+{
+  ULong64_t z = seed + 0x9E3779B97F4A7C15ULL * (instance + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  return z % 900000000 + 1;
+}
+} // namespace
+
+//------------------------------------------------------------------------------
+
+struct PileUpMergerPythia8::TPileUpPool
+{
+  vector<Pythia8::Pythia *> generators;
+  vector<thread> threads;
+
+  // ring of generated events, count events are ready starting from head
+  vector<TPileUpEvent> ring;
+  size_t head, count;
+
+  mutex ringMutex;
+  condition_variable notEmpty, notFull;
+  bool stop;
+
+  Double_t ptMin;
+
+  TPileUpEvent current;
+
+  void Generate(Pythia8::Pythia *pythia);
+  void Next();
+};
+
+//------------------------------------------------------------------------------
+
+void PileUpMergerPythia8::TPileUpPool::Generate(Pythia8::Pythia *pythia)
+{
+  TPileUpEvent event;
+
+  while(true)
+  {
+    while(!pythia->next())
+      ;
+
+    FillPileUpEvent(pythia, ptMin, event);
+
+    unique_lock<mutex> lock(ringMutex);
+    while(!stop && count == ring.size()) notFull.wait(lock);
+    if(stop) return;
+
+    swap(ring[(head + count) % ring.size()], event);
+    ++count;
+    notEmpty.notify_one();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void PileUpMergerPythia8::TPileUpPool::Next()
+{
+  unique_lock<mutex> lock(ringMutex);
+  while(count == 0) notEmpty.wait(lock);
+
+  swap(current, ring[head]);
+  head = (head + 1) % ring.size();
+  --count;
+  notFull.notify_one();
+}
+
 //------------------------------------------------------------------------------
 
 PileUpMergerPythia8::PileUpMergerPythia8() :
-  fFunction(0), fPythia(0), fItInputArray(0)
+  fFunction(0), fPythia(0), fPool(0), fWriter(0), fItInputArray(0)
 {
   fFunction = new DelphesTF2;
 }
@@ -72,6 +199,9 @@ PileUpMergerPythia8::~PileUpMergerPythia8()
 void PileUpMergerPythia8::Init()
 {
   const char *fileName;
+  Int_t i, numberOfThreads;
+  ULong64_t seed;
+  stringstream command;
 
   fPileUpDistribution = GetInt("PileUpDistribution", 0);
 
@@ -91,8 +221,57 @@ void PileUpMergerPythia8::Init()
   fFunction->SetRange(-fZVertexSpread, -fTVertexSpread, fZVertexSpread, fTVertexSpread);
 
   fileName = GetString("ConfigFile", "MinBias.cmnd");
-  fPythia = new Pythia8::Pythia();
-  fPythia->readFile(fileName);
+
+  fPool = new TPileUpPool;
+  fPool->head = 0;
+  fPool->count = 0;
+  fPool->stop = false;
+  fPool->ptMin = fPTMin;
+
+  numberOfThreads = GetInt("NumberOfThreads", 0);
+  if(numberOfThreads > 0)
+  {
+    fPool->ring.resize(TMath::Max(GetInt("BufferSize", 1000), 1));
+
+    // each generator gets its own seed, derived from RandomSeed,
+    // 0 means a different seed for each job as for Random:seed = 0 in Pythia8
+    seed = GetInt("RandomSeed", 0);
+    if(seed == 0)
+    {
+      random_device device;
+      seed = (ULong64_t(device()) << 32) | device();
+    }
+
+    for(i = 0; i < numberOfThreads; ++i)
+    {
+      Pythia8::Pythia *pythia = new Pythia8::Pythia();
+      pythia->readFile(fileName);
+
+      command.str("");
+      command << "Random:seed = " << GetInstanceSeed(seed, i);
+      pythia->readString("Random:setSeed = on");
+      pythia->readString(command.str());
+      pythia->init();
+
+      fPool->generators.push_back(pythia);
+    }
+
+    for(i = 0; i < numberOfThreads; ++i)
+    {
+      fPool->threads.push_back(thread(&TPileUpPool::Generate, fPool, fPool->generators[i]));
+    }
+  }
+  else
+  {
+    fPythia = new Pythia8::Pythia();
+    fPythia->readFile(fileName);
+  }
+
+  // optionally write the pile-up events to a pile-up library
+  if(TString(GetString("RecycleFile", "")).Length() > 0)
+  {
+    fWriter = new DelphesPileUpWriter(GetString("RecycleFile", ""));
+  }
 
   // import input array
   fInputArray = ImportArray(GetString("InputArray", "Delphes/stableParticles"));
@@ -107,6 +286,38 @@ void PileUpMergerPythia8::Init()
 
 void PileUpMergerPythia8::Finish()
 {
+  vector<thread>::iterator itThreads;
+  vector<Pythia8::Pythia *>::iterator itGenerators;
+
+  if(fPool)
+  {
+    {
+      lock_guard<mutex> lock(fPool->ringMutex);
+      fPool->stop = true;
+    }
+    fPool->notFull.notify_all();
+
+    for(itThreads = fPool->threads.begin(); itThreads != fPool->threads.end(); ++itThreads)
+    {
+      itThreads->join();
+    }
+
+    for(itGenerators = fPool->generators.begin(); itGenerators != fPool->generators.end(); ++itGenerators)
+    {
+      delete *itGenerators;
+    }
+
+    delete fPool;
+    fPool = 0;
+  }
+
+  if(fWriter)
+  {
+    fWriter->WriteIndex();
+    delete fWriter;
+    fWriter = 0;
+  }
+
   if(fPythia) delete fPythia;
 }
 
@@ -116,11 +327,12 @@ void PileUpMergerPythia8::Process()
 {
   TDatabasePDG *pdg = TDatabasePDG::Instance();
   TParticlePDG *pdgParticle;
-  Int_t pid, status;
+  Int_t pid;
   Float_t x, y, z, t, vx, vy;
   Float_t px, py, pz, e;
   Double_t dz, dphi, dt;
-  Int_t numberOfEvents, event, numberOfParticles, i;
+  Int_t numberOfEvents, event, numberOfParticles;
+  vector<TPileUpParticle>::const_iterator itParticles;
   Candidate *candidate, *vertex;
   DelphesFactory *factory;
 
@@ -177,8 +389,18 @@ void PileUpMergerPythia8::Process()
 
   for(event = 0; event < numberOfEvents; ++event)
   {
-    while(!fPythia->next())
-      ;
+    if(fPythia)
+    {
+      while(!fPythia->next())
+        ;
+      FillPileUpEvent(fPythia, fPTMin, fPool->current);
+    }
+    else
+    {
+      fPool->Next();
+    }
+
+    const TPileUpEvent &pileUpEvent = fPool->current;
 
     // --- Pile-up vertex smearing
 
@@ -191,24 +413,22 @@ void PileUpMergerPythia8::Process()
 
     vx = 0.0;
     vy = 0.0;
-    numberOfParticles = fPythia->event.size();
-    for(i = 1; i < numberOfParticles; ++i)
+    numberOfParticles = pileUpEvent.size;
+    for(itParticles = pileUpEvent.particles.begin(); itParticles != pileUpEvent.particles.end(); ++itParticles)
     {
-      Pythia8::Particle &particle = fPythia->event[i];
+      const TPileUpParticle &particle = *itParticles;
 
-      status = particle.statusHepMC();
+      pid = particle.pid;
+      px = particle.px;
+      py = particle.py;
+      pz = particle.pz;
+      e = particle.e;
+      x = particle.x;
+      y = particle.y;
+      z = particle.z;
+      t = particle.t;
 
-      if(status != 1 || !particle.isVisible() || particle.pT() <= fPTMin) continue;
-
-      pid = particle.id();
-      px = particle.px();
-      py = particle.py();
-      pz = particle.pz();
-      e = particle.e();
-      x = particle.xProd();
-      y = particle.yProd();
-      z = particle.zProd();
-      t = particle.tProd();
+      if(fWriter) fWriter->WriteParticle(pid, x, y, z, t, px, py, pz, e);
 
       candidate = factory->NewCandidate();
 
@@ -237,6 +457,8 @@ void PileUpMergerPythia8::Process()
       fParticleOutputArray->Add(candidate);
     }
 
+    if(fWriter) fWriter->WriteEntry();
+
     if(numberOfParticles > 0)
     {
       vx /= numberOfParticles;
@@ -23,6 +23,12 @@
  *
  *  Merges particles from pile-up sample into event
  *
+ *  With NumberOfThreads > 0, minimum-bias events are generated ahead of time
+ *  by independently seeded Pythia8 instances running on background threads,
+ *  and stored in a bounded ring of events that Process consumes.
+ *  With RecycleFile set, the merged pile-up events are also written
+ *  to a pile-up library that can be read back by PileUpMerger.
+ *
  *  \author M. Selvaggi - UCL, Louvain-la-Neuve
  *
  */
@@ -31,6 +37,7 @@
 
 class TObjArray;
 class DelphesTF2;
+class DelphesPileUpWriter;
 
 namespace Pythia8
 {
@@ -65,6 +72,12 @@ private:
 
   Pythia8::Pythia *fPythia; //!
 
+  struct TPileUpPool;
+
+  TPileUpPool *fPool; //!
+
+  DelphesPileUpWriter *fWriter; //!
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
@@ -3,6 +3,9 @@
  *  Give pseudo b-tag scores to each jet by sampling from a given distribution
  *  depending on the ground truth flavor, \eta, and PT of each jet.
  *
+ *  Optionally, the scores of the jets of an event are correlated with a
+ *  Gaussian copula, with a correlation depending on event variables.
+ *
  *  \author J. Huang - Brown U, Providence
  *
  */
@@ -12,14 +15,13 @@ ClassImp(PseudoBTagScore)
 
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesClasses.h"
-#include <TFile.h>
-#include <TH1.h>           // for TH1*
+#include "classes/DelphesBTagScoreSampler.h"
+#include "classes/DelphesEventFormula.h"
 #include <TRandom.h>       // for gRandom
+#include <cmath>           // for std::sqrt, std::erfc
 #include <stdexcept>       // for std::runtime_error
-#include <algorithm>       // for std::upper_bound
-#include <iterator>        // for std::distance
+#include <string>          // for std::string
 #include <vector>          // for std::vector
-#include <cmath>           // std::abs
 
 //------------------------------------------------------------------------------
 
@@ -27,94 +29,98 @@ ClassImp(PseudoBTagScore)
 PseudoBTagScore::PseudoBTagScore() : 
   fItJetInputArray(nullptr),
   fJetInputArray(nullptr),
-  fFile_b(nullptr), 
-  fFile_nonb(nullptr),
-  fNbinsPT(0),
-  fNbinsAbsEta(0)
+  fSampler(nullptr),
+  fCopula(false),
+  fCorrelationFormula(nullptr),
+  fPileUpInputArray(nullptr)
 {
+  fSampler = new DelphesBTagScoreSampler;
+  fCorrelationFormula = new DelphesEventFormula;
 }
 
 //------------------------------------------------------------------------------
 
 PseudoBTagScore::~PseudoBTagScore() 
 {
+  if (fSampler) delete fSampler;
+  if (fCorrelationFormula) delete fCorrelationFormula;
 }
 
 //------------------------------------------------------------------------------
 
 void PseudoBTagScore::Init() 
 {
-  // load the files
-  const char *file_b_dir    = GetString("Jet_btagDeepFlavB_file_b",    "");
-  const char *file_nonb_dir = GetString("Jet_btagDeepFlavB_file_nonb", "");
-
-  fFile_b    = new TFile(file_b_dir,     "READ");
-  fFile_nonb = new TFile(file_nonb_dir,  "READ");
-
-  if(!fFile_b || fFile_b->IsZombie())
-    throw std::runtime_error(Form(
-      "PseudoBTagScore: cannot open the b file at %s", file_b_dir));
-
-  if(!fFile_nonb || fFile_nonb->IsZombie())
-    throw std::runtime_error(Form(
-      "PseudoBTagScore: cannot open the non-b file at %s", file_nonb_dir));
-
-  //----------*----------*----------
-
   // read bin edges - taken from ParticleDensity.cc
   ExRootConfParam paramPT = GetParam("PTBins");
   Int_t sizePT = paramPT.GetSize();
-  fPtBins.reserve(sizePT);
+  std::vector<Double_t> ptBins;
+  ptBins.reserve(sizePT);
   for(Int_t i = 0; i < sizePT; ++i) {
-    fPtBins.push_back(paramPT[i].GetDouble());
+    ptBins.push_back(paramPT[i].GetDouble());
   }
-  fNbinsPT = sizePT - 1;
 
   ExRootConfParam paramAbsEta = GetParam("AbsEtaBins");
   Int_t sizeAbsEta = paramAbsEta.GetSize();
-  fAbsEtaBins.reserve(sizeAbsEta);
+  std::vector<Double_t> absEtaBins;
+  absEtaBins.reserve(sizeAbsEta);
   for(Int_t i = 0; i < sizeAbsEta; ++i) {
-    fAbsEtaBins.push_back(paramAbsEta[i].GetDouble());
+    absEtaBins.push_back(paramAbsEta[i].GetDouble());
   }
-  fNbinsAbsEta = sizeAbsEta - 1;
 
   //----------*----------*----------
 
-  // load all the histograms
-  fHists_b.resize(fNbinsAbsEta);
-  fHists_nonb.resize(fNbinsAbsEta);
-
-  for (Int_t i = 0; i < fNbinsAbsEta; ++i) {
-    fHists_b[i].resize(fNbinsPT);
-    fHists_nonb[i].resize(fNbinsPT);
-
-    for (Int_t j = 0; j < fNbinsPT; ++j) {
-      // The naming convention of each histogram in the .root file is  hist_eta[X]_pt[Y]
-      TString nameB    = Form("hist_eta%d_pt%d", i, j);
-      TString nameNonB = Form("hist_eta%d_pt%d", i, j);
-
-      fHists_b[i][j]      = dynamic_cast<TH1*>(fFile_b->Get(nameB));
-      fHists_nonb[i][j]   = dynamic_cast<TH1*>(fFile_nonb->Get(nameNonB));
-
-      if (!fHists_b[i][j]) {
-        throw std::runtime_error(Form(
-          "PseudoBTagScore: histogram %s not found in b file", nameB.Data()));
-      }
-      if (!fHists_nonb[i][j]) {
-        throw std::runtime_error(Form(
-          "PseudoBTagScore: histogram %s not found in non-b file", nameNonB.Data()));
-      }
+  // OPTIONAL: compiled tables with embedded bin edges, mapped in memory and shared
+  // between processes, see belphes-examples/scripts/compile_btagscore_tables.cpp
+  std::string tableFile = GetString("Jet_btagDeepFlavB_table", "");
+  if (!tableFile.empty()) {
+    fSampler->MapTables(tableFile.c_str());
+
+    // bins in the card are optional, but must agree with the edges of the tables
+    if ((sizePT > 0 || sizeAbsEta > 0) && !fSampler->HasBins(ptBins, absEtaBins)) {
+      throw std::runtime_error(Form(
+        "PseudoBTagScore: PTBins and AbsEtaBins differ from the bin edges in %s", tableFile.c_str()));
     }
+
+  } else {
+    fSampler->SetBins(ptBins, absEtaBins);
+
+    // load all the histograms, the files are closed once the tables are built
+    // The naming convention of each histogram in the .root file is  hist_eta[X]_pt[Y]
+    std::string fileB    = GetString("Jet_btagDeepFlavB_file_b",    "");
+    std::string fileNonB = GetString("Jet_btagDeepFlavB_file_nonb", "");
+    fSampler->ReadHistograms(fileB.c_str(), fileNonB.c_str());
+
   }
 
   //----------*----------*----------
 
+  // OPTIONAL: smooth unbinned scores from monotone splines of the inverse CDFs,
+  // with a fixed number of knots independent of the histogram binning
+  fSampler->Smooth(GetInt("SmoothKnots", 0));
+
+  //----------*----------*----------
+
   // import input array 
   fJetInputArray   = ImportArray(GetString("JetInputArray", "FastJetFinder/jets"));
   fItJetInputArray = fJetInputArray->MakeIterator();
 
   //----------*----------*----------
 
+  // OPTIONAL: Gaussian copula, the jets of an event get correlated normal numbers
+  // with a correlation given by a formula of npu, njets and ht, e.g. "min(0.01*npu, 0.5)"
+  fCopula = false;
+  std::string correlation = GetString("CopulaCorrelation", "");
+  if (!correlation.empty()) {
+    fCorrelationFormula->Compile(correlation.c_str());
+    fCopula = true;
+
+    // npu is the number of pile-up vertices (IsPU set) in this array, 0 if not set
+    std::string pileUpArray = GetString("PileUpInputArray", "");
+    if (!pileUpArray.empty()) fPileUpInputArray = ImportArray(pileUpArray.c_str());
+  }
+
+  //----------*----------*----------
+
   // OPTIONAL: seed the RNG
   UInt_t seed = GetInt("RandomSeed", 0u);
   if(seed != 0u) {
@@ -129,67 +135,93 @@ void PseudoBTagScore::Finish()
 {
   // close off the input jet array
   if (fItJetInputArray) delete fItJetInputArray;
-
-  // also need to close off all files
-  if (fFile_b) 
-  {
-    fFile_b->Close();
-    delete fFile_b;     fFile_b = nullptr;
-  }
-  if (fFile_nonb) 
-  {
-    fFile_nonb->Close();
-    delete fFile_nonb;  fFile_nonb = nullptr;
-  }
 }
 
 //------------------------------------------------------------------------------
 
 void PseudoBTagScore::Process() 
 {
+  if (fCopula) {
+    ProcessCorrelated();
+    return;
+  }
+
   Candidate *jet; // Candidate is a Delphes class that can represent any object
-  Double_t jet_pt,     jet_abseta;
-  Int_t    jet_pt_bin, jet_abseta_bin;
+  Int_t table;
   // loop over all input jets 
   fItJetInputArray->Reset();
   while ((jet = static_cast<Candidate *>(fItJetInputArray->Next()))) // while we pick up next jet from iterator
   {
-    // obtain the pt and eta of the jet 
+    // find the table of the jet from its flavor, pt and abs eta (axial symmetry in the detector)
     const TLorentzVector &jetMomentum = jet->Momentum; // take 4-momentum of jet; TLorentzVector is outdated
-    jet_pt     = jetMomentum.Pt();
-    jet_abseta = std::abs(jetMomentum.Eta()); // we use abs eta because of axial symmetry in the detector
-
-    // pre-set the bin
-    jet_pt_bin     = -1;
-    jet_abseta_bin = -1;
+    table = fSampler->FindTable(jetMomentum.Pt(), jetMomentum.Eta(), jet->Flavor);
 
     //----------*----------*----------
 
-    // find a suitable bin in pt and abseta for the jet 
-    auto it_pt = std::upper_bound(fPtBins.begin(), fPtBins.end(), jet_pt);
-    if (it_pt != fPtBins.begin() && it_pt != fPtBins.end()) {
-      jet_pt_bin = std::distance(fPtBins.begin(), it_pt) - 1;
-    }
+    // sample from the related histogram, like TH1::GetRandom an empty one gives 0 without drawing
+    if (table >= 0) {
+      jet->Jet_btagDeepFlavB = fSampler->IsEmpty(table) ? 0.0 : fSampler->Quantile(table, gRandom->Rndm());
+
+    } else {
+      jet->Jet_btagDeepFlavB = -1.0;
 
-    auto it_abseta = std::upper_bound(fAbsEtaBins.begin(), fAbsEtaBins.end(), jet_abseta);
-    if (it_abseta != fAbsEtaBins.begin() && it_abseta != fAbsEtaBins.end()) {
-      jet_abseta_bin = std::distance(fAbsEtaBins.begin(), it_abseta) - 1;
     }
+  }
+}
 
-    //----------*----------*----------
+//------------------------------------------------------------------------------
 
-    // find the related histogram and sample from it
-    if (jet_pt_bin>=0 && jet_abseta_bin>=0) {
-      auto& histVec = (jet->Flavor==5 ? fHists_b : fHists_nonb);
-      TH1*  hist    = histVec[jet_abseta_bin][jet_pt_bin];
-      Float_t score = hist->GetRandom(); // Jet_btagDeepFlavB is set to be a Float_t
-      jet->Jet_btagDeepFlavB = score;
+void PseudoBTagScore::ProcessCorrelated()
+{
+  Candidate *jet;
+  Int_t nJets = fJetInputArray->GetEntriesFast();
+  Double_t ht = 0.0;
+
+  // collect the jets of the event in one batch
+  fJetPT.resize(nJets);
+  fJetEta.resize(nJets);
+  fJetFlavor.resize(nJets);
+  fJetUniform.resize(nJets);
+  fJetScore.resize(nJets);
+
+  for (Int_t i = 0; i < nJets; ++i) {
+    jet = static_cast<Candidate *>(fJetInputArray->At(i));
+    const TLorentzVector &jetMomentum = jet->Momentum;
+    fJetPT[i]     = jetMomentum.Pt();
+    fJetEta[i]    = jetMomentum.Eta();
+    fJetFlavor[i] = jet->Flavor;
+    ht += fJetPT[i];
+  }
 
-    } else {
-      jet->Jet_btagDeepFlavB = -1.0;
+  //----------*----------*----------
 
+  // equicorrelated normals z_i = sqrt(rho) g + sqrt(1 - rho) e_i share the event term g,
+  // mapped to uniform numbers through the normal CDF, then through the per-bin inverse CDFs
+  // npu counts the pile-up vertices only, the hard-scatter vertex has IsPU = 0
+  Int_t npu = 0;
+  if (fPileUpInputArray) {
+    for (Int_t i = 0; i < fPileUpInputArray->GetEntriesFast(); ++i) {
+      if (static_cast<Candidate *>(fPileUpInputArray->At(i))->IsPU) ++npu;
     }
   }
-}
+  Double_t rho = fCorrelationFormula->Eval(npu, nJets, ht);
+  if (rho < 0.0) rho = 0.0;
+  if (rho > 1.0) rho = 1.0;
 
+  Double_t common  = std::sqrt(rho) * gRandom->Gaus();
+  Double_t scale   = std::sqrt(1.0 - rho);
 
+  for (Int_t i = 0; i < nJets; ++i) {
+    Double_t z = common + scale * gRandom->Gaus();
+    fJetUniform[i] = 0.5 * std::erfc(-z / std::sqrt(2.0));
+  }
+
+  if (nJets > 0) {
+    fSampler->Sample(nJets, &fJetPT[0], &fJetEta[0], &fJetFlavor[0], &fJetUniform[0], &fJetScore[0]);
+  }
+
+  for (Int_t i = 0; i < nJets; ++i) {
+    jet = static_cast<Candidate *>(fJetInputArray->At(i));
+    jet->Jet_btagDeepFlavB = fJetScore[i];
+  }
+}
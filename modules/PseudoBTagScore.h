@@ -6,6 +6,9 @@
  *  Give pseudo b-tag scores to each jet by sampling from a given distribution
  *  depending on the ground truth flavor, \eta, and PT of each jet.
  *
+ *  Optionally, the scores of the jets of an event are correlated with a
+ *  Gaussian copula, with a correlation depending on event variables.
+ *
  *  \author J. Huang - Brown U, Providence
  *
  */
@@ -14,8 +17,9 @@
 #include "classes/DelphesModule.h"
 #include "classes/DelphesClasses.h"   // for the Jet class
 
-class TH1;                // forward-declare ROOT histogram
 class TObjArray;
+class DelphesBTagScoreSampler;
+class DelphesEventFormula;
 
 class PseudoBTagScore : public DelphesModule 
 {
@@ -23,7 +27,7 @@ public:
   PseudoBTagScore();
   ~PseudoBTagScore();
 
-  void Init();     ///< Load histogram from disk
+  void Init();     ///< Load histograms from disk into the sampler
   void Process();  ///< Sample one value per jet
   void Finish();   ///< Clean up
 
@@ -31,16 +35,21 @@ private:
   TIterator            *fItJetInputArray; //!
   const TObjArray      *fJetInputArray;   //!
 
-  TFile                *fFile_b;          //!
-  TFile                *fFile_nonb;       //!
+  DelphesBTagScoreSampler *fSampler;     //!
+
+  void ProcessCorrelated(); ///< Sample all jets of the event through the copula
+
+  Bool_t                fCopula;          //!
+  DelphesEventFormula  *fCorrelationFormula; //!
 
-  std::vector<Float_t>  fPtBins;          //!
-  std::vector<Float_t>  fAbsEtaBins;      //!
-  Int_t                 fNbinsPT;         //!
-  Int_t                 fNbinsAbsEta;     //!
+  const TObjArray      *fPileUpInputArray;   //!
 
-  std::vector<std::vector<TH1*>> fHists_b;    //!
-  std::vector<std::vector<TH1*>> fHists_nonb; //!
+  // per-event batch of jets
+  std::vector<Double_t> fJetPT;           //!
+  std::vector<Double_t> fJetEta;          //!
+  std::vector<UInt_t>   fJetFlavor;       //!
+  std::vector<Double_t> fJetUniform;      //!
+  std::vector<Float_t>  fJetScore;        //!
 
   ClassDef(PseudoBTagScore, 1)
 };
@@ -93,12 +93,16 @@ void TimeOfFlight::Finish()
 
 void TimeOfFlight::Process()
 {
-  Candidate *candidate, *particle, *vertex, *constituent, *mother;
+  Candidate *candidate, *particle, *mother;
+  unordered_map<const Candidate *, Candidate *>::const_iterator itVertexMap;
   Double_t ti, t_truth, tf;
   Double_t l, tof, beta;
 
   const Double_t c_light = 2.99792458E8;
 
+  // index tracks and vertices by generator particle
+  BuildParticleMaps();
+
   // first compute momenta of vertices based on reconstructed tracks
   ComputeVertexMomenta();
 
@@ -138,21 +142,11 @@ void TimeOfFlight::Process()
     	{
         // same as 2 but attempt at estimate beta from vertex mass and momentum
         beta = 1.;
-        fItVertexInputArray->Reset();
-        while((vertex = static_cast<Candidate *>(fItVertexInputArray->Next())))
+        itVertexMap = fVertexMap.find(particle);
+        if(itVertexMap != fVertexMap.end())
         {
-          TIter itGenParts(vertex->GetCandidates());
-          itGenParts.Reset();
-
-          while((constituent = static_cast<Candidate *>(itGenParts.Next())))
-          {
-            if (particle == constituent)
-            {
-              beta = vertex->Momentum.Beta();
-              break;
-            }
-          }
-        } // end vertex  loop
+          beta = itVertexMap->second->Momentum.Beta();
+        }
 
         // track displacement to be possibily replaced by vertex fitted position
         ti = candidateInitialPositionSmeared.Vect().Mag() * 1.0E-3 /(beta*c_light);
@@ -188,9 +182,57 @@ void TimeOfFlight::Process()
 
 //------------------------------------------------------------------------------
 
-void TimeOfFlight::ComputeVertexMomenta()
+void TimeOfFlight::BuildParticleMaps()
 {
   Candidate *track, *constituent, *particle, *vertex;
+  Int_t i;
+  unordered_map<const Candidate *, Int_t>::iterator itTrackMap;
+
+  // walk the tracks backwards so that each chain is in track order
+  fTrackMap.clear();
+  fNextTrack.assign(fInputArray->GetEntriesFast(), -1);
+  for(i = fInputArray->GetEntriesFast() - 1; i >= 0; --i)
+  {
+    track = static_cast<Candidate *>(fInputArray->At(i));
+
+    // get gen part that generated track
+    particle = static_cast<Candidate *>(track->GetCandidates()->At(0));
+
+    itTrackMap = fTrackMap.find(particle);
+    if(itTrackMap == fTrackMap.end())
+    {
+      fTrackMap[particle] = i;
+    }
+    else
+    {
+      fNextTrack[i] = itTrackMap->second;
+      itTrackMap->second = i;
+    }
+  }
+
+  fVertexMap.clear();
+  if(fVertexTimeMode != 2) return;
+
+  fItVertexInputArray->Reset();
+  while((vertex = static_cast<Candidate *>(fItVertexInputArray->Next())))
+  {
+    TIter itGenParts(vertex->GetCandidates());
+    itGenParts.Reset();
+
+    while((constituent = static_cast<Candidate *>(itGenParts.Next())))
+    {
+      fVertexMap[constituent] = vertex;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void TimeOfFlight::ComputeVertexMomenta()
+{
+  Candidate *track, *constituent, *vertex;
+  Int_t i;
+  unordered_map<const Candidate *, Int_t>::const_iterator itTrackMap;
 
   fItVertexInputArray->Reset();
   while((vertex = static_cast<Candidate *>(fItVertexInputArray->Next())))
@@ -201,16 +243,13 @@ void TimeOfFlight::ComputeVertexMomenta()
 
     while((constituent = static_cast<Candidate *>(itGenParts.Next())))
     {
-      fItInputArray->Reset();
-      while((track = static_cast<Candidate *>(fItInputArray->Next())))
-      {
-        // get gen part that generated track
-        particle = static_cast<Candidate *>(track->GetCandidates()->At(0));
-        if (particle == constituent)
-        {
-          vertex->Momentum += track->Momentum;
-        }
+      itTrackMap = fTrackMap.find(constituent);
+      if(itTrackMap == fTrackMap.end()) continue;
 
+      for(i = itTrackMap->second; i >= 0; i = fNextTrack[i])
+      {
+        track = static_cast<Candidate *>(fInputArray->At(i));
+        vertex->Momentum += track->Momentum;
       } // end track loop
     } // end vertex consitutent loop
   } // end vertex  loop
@@ -29,8 +29,12 @@
 
 #include "classes/DelphesModule.h"
 
+#include <unordered_map>
+#include <vector>
+
 class TIterator;
 class TObjArray;
+class Candidate;
 
 class TimeOfFlight: public DelphesModule
 {
@@ -45,6 +49,8 @@ public:
 
 private:
 
+  void BuildParticleMaps();
+
   Int_t fVertexTimeMode;
 
   TIterator *fItInputArray; //!
@@ -55,6 +61,14 @@ private:
 
   TObjArray *fOutputArray; //!
 
+  // per-event generator particle to first track index, further tracks
+  // of the same particle are chained through fNextTrack
+  std::unordered_map<const Candidate *, Int_t> fTrackMap; //!
+  std::vector<Int_t> fNextTrack; //!
+
+  // per-event generator particle to the last vertex containing it
+  std::unordered_map<const Candidate *, Candidate *> fVertexMap; //!
+
   ClassDef(TimeOfFlight, 1)
 };
 
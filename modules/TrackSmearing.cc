@@ -9,6 +9,7 @@
 #include "modules/TrackSmearing.h"
 
 #include "classes/DelphesClasses.h"
+#include "classes/DelphesDensityGrid.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
 
@@ -36,7 +37,7 @@ using namespace std;
 //------------------------------------------------------------------------------
 
 TrackSmearing::TrackSmearing() :
-  fD0Formula(0), fDZFormula(0), fPFormula(0), fCtgThetaFormula(0), fPhiFormula(0), fItInputArray(0)
+  fD0Formula(0), fDZFormula(0), fPFormula(0), fCtgThetaFormula(0), fPhiFormula(0), fItInputArray(0), fDensityMapInputArray(0)
 {
   fD0Formula = new DelphesFormula;
   fDZFormula = new DelphesFormula;
@@ -138,6 +139,15 @@ void TrackSmearing::Init()
     fBeamSpotInputArray = 0;
   }
 
+  // import density map exported by ParticleDensity (optional),
+  // used for the density variable of the formulas and written
+  // on the output candidates, which are then clones of the input ones
+
+  if(TString(GetString("DensityMapInputArray", "")).Length() > 0)
+  {
+    fDensityMapInputArray = ImportArray(GetString("DensityMapInputArray", ""));
+  }
+
   // create output array
 
   fOutputArray = ExportArray(GetString("OutputArray", "stableParticles"));
@@ -157,7 +167,7 @@ void TrackSmearing::Process()
   Int_t iCandidate = 0;
   TLorentzVector beamSpotPosition;
   Candidate *candidate, *mother;
-  Double_t pt, eta, e, m, d0, d0Error, trueD0, dz, dzError, trueDZ, p, pError, trueP, ctgTheta, ctgThetaError, trueCtgTheta, phi, phiError, truePhi;
+  Double_t pt, eta, e, m, d0, d0Error, trueD0, dz, dzError, trueDZ, p, pError, trueP, ctgTheta, ctgThetaError, trueCtgTheta, phi, phiError, truePhi, density;
   Double_t x, y, z, t, px, py, pz, theta;
   Double_t q, r;
   Double_t x_c, y_c, r_c, phi_0;
@@ -168,6 +178,12 @@ void TrackSmearing::Process()
              *pErrorHist = NULL,
              *ctgThetaErrorHist = NULL,
              *phiErrorHist = NULL;
+  DelphesDensityGrid *densityMap = 0;
+
+  if(fDensityMapInputArray && fDensityMapInputArray->GetEntriesFast() > 0)
+  {
+    densityMap = static_cast<DelphesDensityGrid *>(fDensityMapInputArray->At(0));
+  }
 
   if(!fBeamSpotInputArray || fBeamSpotInputArray->GetSize() == 0)
     beamSpotPosition.SetXYZT(0.0, 0.0, 0.0, 0.0);
@@ -232,8 +248,12 @@ void TrackSmearing::Process()
     ctgTheta = trueCtgTheta = candidate->CtgTheta;
     phi = truePhi = candidate->Phi;
 
+    // the input candidate can be shared with other arrays,
+    // the density is only written on the output clone
+    density = densityMap ? densityMap->GetDensity(candidate) : candidate->ParticleDensity;
+
     if(fUseD0Formula)
-      d0Error = fD0Formula->Eval(pt, eta, phi, e, candidate);
+      d0Error = fD0Formula->Eval(pt, eta, phi, e, candidate, density);
     else
     {
       Int_t xbin, ybin;
@@ -248,7 +268,7 @@ void TrackSmearing::Process()
       continue;
 
     if(fUseDZFormula)
-      dzError = fDZFormula->Eval(pt, eta, phi, e, candidate);
+      dzError = fDZFormula->Eval(pt, eta, phi, e, candidate, density);
     else
     {
       Int_t xbin, ybin;
@@ -263,7 +283,7 @@ void TrackSmearing::Process()
       continue;
 
     if(fUsePFormula)
-      pError = fPFormula->Eval(pt, eta, phi, e, candidate) * p;
+      pError = fPFormula->Eval(pt, eta, phi, e, candidate, density) * p;
     else
     {
       Int_t xbin, ybin;
@@ -278,7 +298,7 @@ void TrackSmearing::Process()
       continue;
 
     if(fUseCtgThetaFormula)
-      ctgThetaError = fCtgThetaFormula->Eval(pt, eta, phi, e, candidate);
+      ctgThetaError = fCtgThetaFormula->Eval(pt, eta, phi, e, candidate, density);
     else
     {
       Int_t xbin, ybin;
@@ -293,7 +313,7 @@ void TrackSmearing::Process()
       continue;
 
     if(fUsePhiFormula)
-      phiError = fPhiFormula->Eval(pt, eta, phi, e, candidate);
+      phiError = fPhiFormula->Eval(pt, eta, phi, e, candidate, density);
     else
     {
       Int_t xbin, ybin;
@@ -322,6 +342,7 @@ void TrackSmearing::Process()
 
     mother = candidate;
     candidate = static_cast<Candidate *>(candidate->Clone());
+    candidate->ParticleDensity = density;
     candidate->D0 = d0;
     candidate->DZ = dz;
     candidate->P = p;
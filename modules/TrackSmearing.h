@@ -64,6 +64,8 @@ private:
   const TObjArray *fInputArray; //!
   const TObjArray *fBeamSpotInputArray; //!
 
+  const TObjArray *fDensityMapInputArray; //!
+
   TObjArray *fOutputArray; //!
 
   ClassDef(TrackSmearing, 1)
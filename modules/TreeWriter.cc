@@ -20,6 +20,16 @@
  *
  *  Fills ROOT tree branches.
  *
+ *  With OutputMode set to Flat, each branch is written as plain arrays of
+ *  basic types ("<Branch>_<Field>[<Branch>_size]"), TLorentzVector members
+ *  are split into PT, Eta, Phi and Mass columns, and TRef/TRefArray links
+ *  are replaced by row indices into the other written branches.
+ *
+ *  With IndexLinks set to true, the usual object branches are written
+ *  without TRef/TRefArray links, and the Particle(s) and Constituents links
+ *  are stored instead as "<Branch>_<Field>" collections of (object, index,
+ *  branch) rows pointing into the other written branches.
+ *
  *  \author P. Demin - UCL, Louvain-la-Neuve
  *
  */
@@ -34,27 +44,50 @@
 #include "ExRootAnalysis/ExRootFilter.h"
 #include "ExRootAnalysis/ExRootResult.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
 
+#include "TClass.h"
+#include "TDataMember.h"
+#include "TDataType.h"
 #include "TDatabasePDG.h"
 #include "TFormula.h"
+#include "TList.h"
 #include "TLorentzVector.h"
 #include "TMath.h"
 #include "TObjArray.h"
 #include "TROOT.h"
 #include "TRandom3.h"
+#include "TRef.h"
+#include "TRefArray.h"
 #include "TString.h"
 
-#include <set>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 
 using namespace std;
 
+namespace
+{
+// kinds of columns written in the flat output mode
+enum
+{
+  kFlatBasic,
+  kFlatLorentzVector,
+  kFlatRef,
+  kFlatRefArray
+};
+
+// object number part of a TProcessID unique ID
+const UInt_t kFlatUIDMask = 0xffffff;
+} // namespace
+
 //------------------------------------------------------------------------------
 
-TreeWriter::TreeWriter()
+TreeWriter::TreeWriter() :
+  fFlat(kFALSE), fIndexLinks(kFALSE)
 {
 }
 
@@ -62,6 +95,11 @@ TreeWriter::TreeWriter()
 
 TreeWriter::~TreeWriter()
 {
+  vector<TFlatBranch>::iterator itFlatBranches;
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    delete itFlatBranches->staging;
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -90,12 +128,23 @@ void TreeWriter::Init()
   // read branch configuration and
   // import array with output from filter/classifier/jetfinder modules
 
+  fFlat = (TString(GetString("OutputMode", "Default")) == "Flat");
+
+  // links are already written as row indices in the flat output mode
+  fIndexLinks = !fFlat && GetBool("IndexLinks", false);
+
   ExRootConfParam param = GetParam("Branch");
-  Long_t i, size;
+  ExRootConfParam fieldsParam = GetParam("FlatFields");
+  ExRootConfParam fields;
+  Long_t i, j, size;
   TString branchName, branchClassName, branchInputArray;
   TClass *branchClass;
   TObjArray *array;
   ExRootTreeBranch *branch;
+  Bool_t hasFields;
+  TIndexLink link;
+
+  const char *linkFields[3] = {"Particle", "Particles", "Constituents"};
 
   size = param.GetSize();
   for(i = 0; i < size / 3; ++i)
@@ -120,8 +169,45 @@ void TreeWriter::Init()
     }
 
     array = ImportArray(branchInputArray);
-    branch = NewBranch(branchName, branchClass);
 
+    if(fFlat)
+    {
+      // objects are filled as usual into a branch that is not attached
+      // to the tree, and then copied into the flat columns
+      hasFields = kFALSE;
+      for(j = 0; j < fieldsParam.GetSize() / 2; ++j)
+      {
+        if(branchName == fieldsParam[j * 2].GetString())
+        {
+          fields = fieldsParam[j * 2 + 1];
+          hasFields = kTRUE;
+        }
+      }
+
+      branch = new ExRootTreeBranch(branchName, branchClass, 0);
+      InitFlatBranch(branchName, branchClass, branch, hasFields ? &fields : 0);
+    }
+    else
+    {
+      branch = NewBranch(branchName, branchClass);
+    }
+
+    if(fIndexLinks)
+    {
+      for(j = 0; j < 3; ++j)
+      {
+        if(!branchClass->GetDataMember(linkFields[j])) continue;
+        link.branch = branch;
+        link.field = linkFields[j];
+        link.links = NewFlatBranch(branchName + "_" + linkFields[j]);
+        link.links->AddColumn("object", 'I');
+        link.links->AddColumn("index", 'I');
+        link.links->AddColumn("branch", 'I');
+        fIndexLinkList.push_back(link);
+      }
+    }
+
+    fWrittenBranches.push_back(branch);
     fBranchMap.insert(make_pair(branch, make_pair(itClassMap->second, array)));
   }
 
@@ -147,15 +233,131 @@ void TreeWriter::Finish()
 
 //------------------------------------------------------------------------------
 
-void TreeWriter::FillParticles(Candidate *candidate, TRefArray *array)
+void TreeWriter::InitFlatBranch(const char *name, TClass *cl, ExRootTreeBranch *staging, ExRootConfParam *fields)
 {
+  TFlatBranch flatBranch;
+  TFlatField field;
+  TDataMember *member;
+  TDataType *dataType;
+  TString memberName, typeName, columnName;
+  Char_t type;
+  Int_t i, j, size;
+  Bool_t selected;
+
+  const char *components[4] = {"PT", "Eta", "Phi", "Mass"};
+
+  flatBranch.staging = staging;
+  flatBranch.flat = NewFlatBranch(name);
+
+  TIter itMembers(cl->GetListOfDataMembers());
+  while((member = static_cast<TDataMember *>(itMembers.Next())))
+  {
+    if(!member->IsPersistent() || member->GetArrayDim() > 1) continue;
+
+    memberName = member->GetName();
+
+    if(fields)
+    {
+      selected = kFALSE;
+      size = fields->GetSize();
+      for(i = 0; i < size; ++i)
+      {
+        if(memberName == (*fields)[i].GetString()) selected = kTRUE;
+      }
+      if(!selected) continue;
+    }
+
+    typeName = member->GetTypeName();
+
+    field.offset = member->GetOffset();
+    field.length = (member->GetArrayDim() == 1) ? member->GetMaxIndex(0) : 1;
+    field.links = 0;
+    field.columns.clear();
+
+    if(member->IsBasic())
+    {
+      dataType = member->GetDataType();
+      if(!dataType) continue;
+
+      switch(dataType->GetType())
+      {
+        case kFloat_t: type = 'F'; break;
+        case kDouble_t: type = 'D'; break;
+        case kDouble32_t: type = 'D'; break;
+        case kInt_t: type = 'I'; break;
+        case kUInt_t: type = 'i'; break;
+        case kBool_t: type = 'O'; break;
+        default: type = 0;
+      }
+      if(!type) continue;
+
+      field.kind = kFlatBasic;
+      field.typeSize = dataType->Size();
+      for(j = 0; j < field.length; ++j)
+      {
+        columnName = memberName;
+        if(field.length > 1) columnName += Form("_%d", j);
+        field.columns.push_back(flatBranch.flat->AddColumn(columnName, type));
+      }
+    }
+    else if(typeName == "TLorentzVector")
+    {
+      field.kind = kFlatLorentzVector;
+      field.typeSize = sizeof(TLorentzVector);
+      for(j = 0; j < field.length; ++j)
+      {
+        for(i = 0; i < 4; ++i)
+        {
+          columnName = memberName;
+          if(field.length > 1) columnName += Form("_%d", j);
+          columnName += TString("_") + components[i];
+          field.columns.push_back(flatBranch.flat->AddColumn(columnName, 'F'));
+        }
+      }
+    }
+    else if(typeName == "TRef" && field.length == 1)
+    {
+      // row index and branch index of the referenced object
+      field.kind = kFlatRef;
+      field.columns.push_back(flatBranch.flat->AddColumn(memberName + "_index", 'I'));
+      field.columns.push_back(flatBranch.flat->AddColumn(memberName + "_branch", 'I'));
+    }
+    else if(typeName == "TRefArray" && field.length == 1)
+    {
+      // number of links per object, and the links themselves
+      // in a separate "<Branch>_<Field>" collection
+      field.kind = kFlatRefArray;
+      field.columns.push_back(flatBranch.flat->AddColumn("n" + memberName, 'I'));
+      field.links = NewFlatBranch(TString(name) + "_" + memberName);
+      field.links->AddColumn("index", 'I');
+      field.links->AddColumn("branch", 'I');
+    }
+    else
+    {
+      continue;
+    }
+
+    flatBranch.fields.push_back(field);
+  }
+
+  fFlatBranches.push_back(flatBranch);
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::CollectParticles(Candidate *candidate)
+{
+  // collect the generated particles behind a candidate (directly, through
+  // a track, or through the towers), keeping each of them only once
+
   TIter it1(candidate->GetCandidates());
-  set<Candidate *> s;
-  set<Candidate *>::iterator it3;
-  it1.Reset();
-  s.clear();
-  array->Clear();
+  vector<Candidate *>::iterator itParticles;
+  Candidate *particle;
+  UInt_t uid;
+
+  fParticles.clear();
 
+  it1.Reset();
   while((candidate = static_cast<Candidate *>(it1.Next())))
   {
     TIter it2(candidate->GetCandidates());
@@ -163,15 +365,15 @@ void TreeWriter::FillParticles(Candidate *candidate, TRefArray *array)
     // particle
     if(candidate->GetCandidates()->GetEntriesFast() == 0)
     {
-      s.insert(candidate);
+      fParticles.push_back(candidate);
       continue;
     }
 
     // track
-    candidate = static_cast<Candidate *>(candidate->GetCandidates()->At(0));
-    if(candidate->GetCandidates()->GetEntriesFast() == 0)
+    particle = static_cast<Candidate *>(candidate->GetCandidates()->At(0));
+    if(particle->GetCandidates()->GetEntriesFast() == 0)
     {
-      s.insert(candidate);
+      fParticles.push_back(particle);
       continue;
     }
 
@@ -182,14 +384,85 @@ void TreeWriter::FillParticles(Candidate *candidate, TRefArray *array)
       candidate = static_cast<Candidate *>(candidate->GetCandidates()->At(0));
       if(candidate->GetCandidates()->GetEntriesFast() == 0)
       {
-        s.insert(candidate);
+        fParticles.push_back(candidate);
       }
     }
   }
 
-  for(it3 = s.begin(); it3 != s.end(); ++it3)
+  // remove duplicates using a bitmap indexed by the per-event unique ID,
+  // and reset only the entries that have been set
+
+  itParticles = fParticles.begin();
+  for(vector<Candidate *>::iterator it = fParticles.begin(); it != fParticles.end(); ++it)
+  {
+    uid = (*it)->GetUniqueID() & kFlatUIDMask;
+    if(uid >= fVisited.size()) fVisited.resize(2 * uid + 1, 0);
+    if(fVisited[uid]) continue;
+    fVisited[uid] = 1;
+    *itParticles++ = *it;
+  }
+  fParticles.erase(itParticles, fParticles.end());
+
+  for(itParticles = fParticles.begin(); itParticles != fParticles.end(); ++itParticles)
+  {
+    fVisited[(*itParticles)->GetUniqueID() & kFlatUIDMask] = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::FillParticles(Candidate *candidate, TRefArray *array)
+{
+  vector<Candidate *>::iterator itParticles;
+
+  CollectParticles(candidate);
+
+  // keep the order in which the links have always been written
+  sort(fParticles.begin(), fParticles.end());
+
+  array->Clear();
+  for(itParticles = fParticles.begin(); itParticles != fParticles.end(); ++itParticles)
+  {
+    array->Add(*itParticles);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+TreeWriter::TIndexLink *TreeWriter::FindIndexLink(ExRootTreeBranch *branch, const char *field)
+{
+  vector<TIndexLink>::iterator itIndexLinks;
+
+  if(!fIndexLinks) return 0;
+
+  for(itIndexLinks = fIndexLinkList.begin(); itIndexLinks != fIndexLinkList.end(); ++itIndexLinks)
+  {
+    if(itIndexLinks->branch == branch && itIndexLinks->field == field) return &(*itIndexLinks);
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::AddIndexLink(TIndexLink *link, Int_t row, const TObject *object)
+{
+  if(!object) return;
+  link->rows.push_back(row);
+  link->uids.push_back(object->GetUniqueID() & kFlatUIDMask);
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::AddIndexLinks(TIndexLink *link, Int_t row, Candidate *candidate)
+{
+  vector<Candidate *>::iterator itParticles;
+
+  CollectParticles(candidate);
+
+  for(itParticles = fParticles.begin(); itParticles != fParticles.end(); ++itParticles)
   {
-    array->Add(*it3);
+    AddIndexLink(link, row, *itParticles);
   }
 }
 
@@ -263,6 +536,7 @@ void TreeWriter::ProcessVertices(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0, *constituent = 0;
   Vertex *entry = 0;
+  TIndexLink *constituentLinks = FindIndexLink(branch, "Constituents");
 
   const Double_t c_light = 2.99792458E8;
 
@@ -322,7 +596,14 @@ void TreeWriter::ProcessVertices(ExRootTreeBranch *branch, TObjArray *array)
     entry->Constituents.Clear();
     while((constituent = static_cast<Candidate *>(itConstituents.Next())))
     {
-      entry->Constituents.Add(constituent);
+      if(constituentLinks)
+      {
+        AddIndexLink(constituentLinks, branch->GetSize() - 1, constituent);
+      }
+      else
+      {
+        entry->Constituents.Add(constituent);
+      }
     }
   }
 }
@@ -335,6 +616,7 @@ void TreeWriter::ProcessTracks(ExRootTreeBranch *branch, TObjArray *array)
   Candidate *candidate = 0;
   Candidate *particle = 0;
   Track *entry = 0;
+  TIndexLink *particleLink = FindIndexLink(branch, "Particle");
   Double_t pt, signz, cosTheta, eta, p, ctgTheta, phi, m;
   const Double_t c_light = 2.99792458E8;
 
@@ -432,7 +714,14 @@ void TreeWriter::ProcessTracks(ExRootTreeBranch *branch, TObjArray *array)
     entry->T = initialPosition.T() * 1.0E-3 / c_light;
     entry->ErrorT =candidate-> ErrorT * 1.0E-3 / c_light;
 
-    entry->Particle = particle;
+    if(particleLink)
+    {
+      AddIndexLink(particleLink, branch->GetSize() - 1, particle);
+    }
+    else
+    {
+      entry->Particle = particle;
+    }
 
     entry->VertexIndex = candidate->ClusterIndex;
   }
@@ -445,6 +734,7 @@ void TreeWriter::ProcessTowers(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Tower *entry = 0;
+  TIndexLink *particleLinks = FindIndexLink(branch, "Particles");
   Double_t pt, signPz, cosTheta, eta;
   const Double_t c_light = 2.99792458E8;
 
@@ -484,7 +774,14 @@ void TreeWriter::ProcessTowers(ExRootTreeBranch *branch, TObjArray *array)
 
     entry->NTimeHits = candidate->NTimeHits;
 
-    FillParticles(candidate, &entry->Particles);
+    if(particleLinks)
+    {
+      AddIndexLinks(particleLinks, branch->GetSize() - 1, candidate);
+    }
+    else
+    {
+      FillParticles(candidate, &entry->Particles);
+    }
   }
 }
 
@@ -496,6 +793,7 @@ void TreeWriter::ProcessParticleFlowCandidates(ExRootTreeBranch *branch, TObjArr
   TIter iterator(array);
   Candidate *candidate = 0;
   ParticleFlowCandidate *entry = 0;
+  TIndexLink *particleLinks = FindIndexLink(branch, "Particles");
   Double_t e, pt, signz, cosTheta, eta, p, ctgTheta, phi, m;
   const Double_t c_light = 2.99792458E8;
 
@@ -608,7 +906,14 @@ void TreeWriter::ProcessParticleFlowCandidates(ExRootTreeBranch *branch, TObjArr
     //entry->T = position.T() * 1.0E-3 / c_light;
     entry->NTimeHits = candidate->NTimeHits;
 
-    FillParticles(candidate, &entry->Particles);
+    if(particleLinks)
+    {
+      AddIndexLinks(particleLinks, branch->GetSize() - 1, candidate);
+    }
+    else
+    {
+      FillParticles(candidate, &entry->Particles);
+    }
   }
 }
 
@@ -619,6 +924,7 @@ void TreeWriter::ProcessPhotons(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Photon *entry = 0;
+  TIndexLink *particleLinks = FindIndexLink(branch, "Particles");
   Double_t pt, signPz, cosTheta, eta;
   const Double_t c_light = 2.99792458E8;
 
@@ -659,7 +965,14 @@ void TreeWriter::ProcessPhotons(ExRootTreeBranch *branch, TObjArray *array)
     // 1: prompt -- 2: non prompt -- 3: fake
     entry->Status = candidate->Status;
 
-    FillParticles(candidate, &entry->Particles);
+    if(particleLinks)
+    {
+      AddIndexLinks(particleLinks, branch->GetSize() - 1, candidate);
+    }
+    else
+    {
+      FillParticles(candidate, &entry->Particles);
+    }
   }
 }
 
@@ -670,6 +983,7 @@ void TreeWriter::ProcessElectrons(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Electron *entry = 0;
+  TIndexLink *particleLink = FindIndexLink(branch, "Particle");
   Double_t pt, signPz, cosTheta, eta;
   const Double_t c_light = 2.99792458E8;
 
@@ -713,7 +1027,14 @@ void TreeWriter::ProcessElectrons(ExRootTreeBranch *branch, TObjArray *array)
 
     entry->EhadOverEem = 0.0;
 
-    entry->Particle = candidate->GetCandidates()->At(0);
+    if(particleLink)
+    {
+      AddIndexLink(particleLink, branch->GetSize() - 1, candidate->GetCandidates()->At(0));
+    }
+    else
+    {
+      entry->Particle = candidate->GetCandidates()->At(0);
+    }
   }
 }
 
@@ -724,6 +1045,7 @@ void TreeWriter::ProcessMuons(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Muon *entry = 0;
+  TIndexLink *particleLink = FindIndexLink(branch, "Particle");
   Double_t pt, signPz, cosTheta, eta;
 
   const Double_t c_light = 2.99792458E8;
@@ -770,7 +1092,14 @@ void TreeWriter::ProcessMuons(ExRootTreeBranch *branch, TObjArray *array)
 
     entry->Charge = candidate->Charge;
 
-    entry->Particle = candidate->GetCandidates()->At(0);
+    if(particleLink)
+    {
+      AddIndexLink(particleLink, branch->GetSize() - 1, candidate->GetCandidates()->At(0));
+    }
+    else
+    {
+      entry->Particle = candidate->GetCandidates()->At(0);
+    }
   }
 }
 
@@ -781,6 +1110,8 @@ void TreeWriter::ProcessJets(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0, *constituent = 0;
   Jet *entry = 0;
+  TIndexLink *particleLinks = FindIndexLink(branch, "Particles");
+  TIndexLink *constituentLinks = FindIndexLink(branch, "Constituents");
   Double_t pt, signPz, cosTheta, eta;
   Double_t ecalEnergy, hcalEnergy;
   const Double_t c_light = 2.99792458E8;
@@ -838,7 +1169,14 @@ void TreeWriter::ProcessJets(ExRootTreeBranch *branch, TObjArray *array)
     hcalEnergy = 0.0;
     while((constituent = static_cast<Candidate *>(itConstituents.Next())))
     {
-      entry->Constituents.Add(constituent);
+      if(constituentLinks)
+      {
+        AddIndexLink(constituentLinks, branch->GetSize() - 1, constituent);
+      }
+      else
+      {
+        entry->Constituents.Add(constituent);
+      }
       ecalEnergy += constituent->Eem;
       hcalEnergy += constituent->Ehad;
     }
@@ -886,7 +1224,14 @@ void TreeWriter::ProcessJets(ExRootTreeBranch *branch, TObjArray *array)
     entry->ExclYmerge45 = candidate->ExclYmerge45;
     entry->ExclYmerge56 = candidate->ExclYmerge56;
 
-    FillParticles(candidate, &entry->Particles);
+    if(particleLinks)
+    {
+      AddIndexLinks(particleLinks, branch->GetSize() - 1, candidate);
+    }
+    else
+    {
+      FillParticles(candidate, &entry->Particles);
+    }
   }
 }
 
@@ -1026,6 +1371,7 @@ void TreeWriter::ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   HectorHit *entry = 0;
+  TIndexLink *particleLink = FindIndexLink(branch, "Particle");
 
   // loop over all roman pot hits
   iterator.Reset();
@@ -1047,7 +1393,166 @@ void TreeWriter::ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array)
     entry->Y = position.Y();
     entry->S = position.Z();
 
-    entry->Particle = candidate->GetCandidates()->At(0);
+    if(particleLink)
+    {
+      AddIndexLink(particleLink, branch->GetSize() - 1, candidate->GetCandidates()->At(0));
+    }
+    else
+    {
+      entry->Particle = candidate->GetCandidates()->At(0);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+UInt_t TreeWriter::BuildUIDIndex()
+{
+  vector<ExRootTreeBranch *>::iterator itBranches;
+  ExRootTreeBranch *branch;
+  TObject *object;
+  UInt_t uid, maxUID;
+  Int_t branchIndex, i, size;
+
+  // map the unique ID of every referenced object to its branch and row
+
+  maxUID = 0;
+  for(itBranches = fWrittenBranches.begin(); itBranches != fWrittenBranches.end(); ++itBranches)
+  {
+    branch = *itBranches;
+    size = branch->GetSize();
+    for(i = 0; i < size; ++i)
+    {
+      object = branch->At(i);
+      if(!object->TestBit(kIsReferenced)) continue;
+      uid = object->GetUniqueID() & kFlatUIDMask;
+      if(uid > maxUID) maxUID = uid;
+    }
+  }
+
+  fFlatBranchIndex.assign(maxUID + 1, -1);
+  fFlatRowIndex.assign(maxUID + 1, -1);
+
+  branchIndex = 0;
+  for(itBranches = fWrittenBranches.begin(); itBranches != fWrittenBranches.end(); ++itBranches, ++branchIndex)
+  {
+    branch = *itBranches;
+    size = branch->GetSize();
+    for(i = 0; i < size; ++i)
+    {
+      object = branch->At(i);
+      if(!object->TestBit(kIsReferenced)) continue;
+      uid = object->GetUniqueID() & kFlatUIDMask;
+      fFlatBranchIndex[uid] = branchIndex;
+      fFlatRowIndex[uid] = i;
+    }
+  }
+
+  return maxUID;
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::ProcessIndexLinks()
+{
+  vector<TIndexLink>::iterator itIndexLinks;
+  ExRootTreeFlatBranch *links;
+  UInt_t uid, maxUID;
+  Int_t row;
+  size_t i;
+
+  maxUID = BuildUIDIndex();
+
+  for(itIndexLinks = fIndexLinkList.begin(); itIndexLinks != fIndexLinkList.end(); ++itIndexLinks)
+  {
+    links = itIndexLinks->links;
+    for(i = 0; i < itIndexLinks->uids.size(); ++i)
+    {
+      uid = itIndexLinks->uids[i];
+      row = links->NewEntry();
+      links->SetValue(0, row, itIndexLinks->rows[i]);
+      links->SetValue(1, row, (uid > 0 && uid <= maxUID) ? fFlatRowIndex[uid] : -1);
+      links->SetValue(2, row, (uid > 0 && uid <= maxUID) ? fFlatBranchIndex[uid] : -1);
+    }
+    itIndexLinks->rows.clear();
+    itIndexLinks->uids.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::ProcessFlat()
+{
+  vector<TFlatBranch>::iterator itFlatBranches;
+  vector<TFlatField>::iterator itFields;
+  ExRootTreeBranch *staging;
+  ExRootTreeFlatBranch *flat, *links;
+  Char_t *address;
+  TRefArray *refArray;
+  UInt_t uid, maxUID;
+  Int_t i, j, k, row, link, size, entries;
+  Double_t pt;
+
+  maxUID = BuildUIDIndex();
+
+  // copy the objects into the flat columns
+
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    staging = itFlatBranches->staging;
+    flat = itFlatBranches->flat;
+    size = staging->GetSize();
+    for(i = 0; i < size; ++i)
+    {
+      address = reinterpret_cast<Char_t *>(staging->At(i));
+      row = flat->NewEntry();
+
+      for(itFields = itFlatBranches->fields.begin(); itFields != itFlatBranches->fields.end(); ++itFields)
+      {
+        const TFlatField &field = *itFields;
+        switch(field.kind)
+        {
+          case kFlatBasic:
+            for(j = 0; j < field.length; ++j)
+            {
+              memcpy(flat->GetAddress(field.columns[j], row), address + field.offset + j * field.typeSize, field.typeSize);
+            }
+            break;
+
+          case kFlatLorentzVector:
+            for(j = 0; j < field.length; ++j)
+            {
+              const TLorentzVector &momentum = *reinterpret_cast<TLorentzVector *>(address + field.offset + j * field.typeSize);
+              pt = momentum.Pt();
+              flat->SetValue(field.columns[j * 4 + 0], row, pt);
+              flat->SetValue(field.columns[j * 4 + 1], row, (pt > 0.0) ? momentum.Eta() : 0.0);
+              flat->SetValue(field.columns[j * 4 + 2], row, momentum.Phi());
+              flat->SetValue(field.columns[j * 4 + 3], row, momentum.M());
+            }
+            break;
+
+          case kFlatRef:
+            uid = reinterpret_cast<TRef *>(address + field.offset)->GetUniqueID() & kFlatUIDMask;
+            flat->SetValue(field.columns[0], row, (uid > 0 && uid <= maxUID) ? fFlatRowIndex[uid] : -1);
+            flat->SetValue(field.columns[1], row, (uid > 0 && uid <= maxUID) ? fFlatBranchIndex[uid] : -1);
+            break;
+
+          case kFlatRefArray:
+            refArray = reinterpret_cast<TRefArray *>(address + field.offset);
+            links = field.links;
+            entries = refArray->GetEntriesFast();
+            flat->SetValue(field.columns[0], row, entries);
+            for(k = 0; k < entries; ++k)
+            {
+              uid = refArray->GetUID(k) & kFlatUIDMask;
+              link = links->NewEntry();
+              links->SetValue(0, link, (uid > 0 && uid <= maxUID) ? fFlatRowIndex[uid] : -1);
+              links->SetValue(1, link, (uid > 0 && uid <= maxUID) ? fFlatBranchIndex[uid] : -1);
+            }
+            break;
+        }
+      }
+    }
   }
 }
 
@@ -1056,10 +1561,16 @@ void TreeWriter::ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array)
 void TreeWriter::Process()
 {
   TBranchMap::iterator itBranchMap;
+  vector<TFlatBranch>::iterator itFlatBranches;
   ExRootTreeBranch *branch;
   TProcessMethod method;
   TObjArray *array;
 
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    itFlatBranches->staging->Clear();
+  }
+
   for(itBranchMap = fBranchMap.begin(); itBranchMap != fBranchMap.end(); ++itBranchMap)
   {
     branch = itBranchMap->first;
@@ -1068,6 +1579,9 @@ void TreeWriter::Process()
 
     (this->*method)(branch, array);
   }
+
+  if(fFlat) ProcessFlat();
+  if(fIndexLinks) ProcessIndexLinks();
 }
 
 //------------------------------------------------------------------------------
@@ -23,20 +23,35 @@
  *
  *  Fills ROOT tree branches.
  *
+ *  With OutputMode set to Flat, each branch is written as plain arrays of
+ *  basic types ("<Branch>_<Field>[<Branch>_size]"), TLorentzVector members
+ *  are split into PT, Eta, Phi and Mass columns, and TRef/TRefArray links
+ *  are replaced by row indices into the other written branches.
+ *
+ *  With IndexLinks set to true, the usual object branches are written
+ *  without TRef/TRefArray links, and the Particle(s) and Constituents links
+ *  are stored instead as "<Branch>_<Field>" collections of (object, index,
+ *  branch) rows pointing into the other written branches.
+ *
  *  \author P. Demin - UCL, Louvain-la-Neuve
  *
  */
 
 #include "classes/DelphesModule.h"
 
+#include "TString.h"
+
 #include <map>
+#include <vector>
 
 class TClass;
 class TObjArray;
 class TRefArray;
 
 class Candidate;
+class ExRootConfParam;
 class ExRootTreeBranch;
+class ExRootTreeFlatBranch;
 
 class TreeWriter: public DelphesModule
 {
@@ -49,6 +64,7 @@ public:
   void Finish();
 
 private:
+  void CollectParticles(Candidate *candidate);
   void FillParticles(Candidate *candidate, TRefArray *array);
 
   void ProcessParticles(ExRootTreeBranch *branch, TObjArray *array);
@@ -68,6 +84,10 @@ private:
   void ProcessWeight(ExRootTreeBranch *branch, TObjArray *array);
   void ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array);
 
+  void InitFlatBranch(const char *name, TClass *cl, ExRootTreeBranch *staging, ExRootConfParam *fields);
+  void ProcessFlat();
+
+  UInt_t BuildUIDIndex();
 
 #if !defined(__CINT__) && !defined(__CLING__)
   typedef void (TreeWriter::*TProcessMethod)(ExRootTreeBranch *, TObjArray *); //!
@@ -77,9 +97,53 @@ private:
   TBranchMap fBranchMap; //!
 
   std::map<TClass *, TProcessMethod> fClassMap; //!
+
+  struct TFlatField
+  {
+    Int_t kind;
+    Long_t offset;
+    Int_t length, typeSize;
+    std::vector<Int_t> columns;
+    ExRootTreeFlatBranch *links;
+  };
+
+  struct TFlatBranch
+  {
+    ExRootTreeBranch *staging;
+    ExRootTreeFlatBranch *flat;
+    std::vector<TFlatField> fields;
+  };
+
+  std::vector<TFlatBranch> fFlatBranches; //!
+
+  std::vector<Int_t> fFlatBranchIndex, fFlatRowIndex; //!
+
+  struct TIndexLink
+  {
+    ExRootTreeBranch *branch;
+    TString field;
+    ExRootTreeFlatBranch *links;
+    std::vector<Int_t> rows;
+    std::vector<UInt_t> uids;
+  };
+
+  TIndexLink *FindIndexLink(ExRootTreeBranch *branch, const char *field);
+  void AddIndexLink(TIndexLink *link, Int_t row, const TObject *object);
+  void AddIndexLinks(TIndexLink *link, Int_t row, Candidate *candidate);
+  void ProcessIndexLinks();
+
+  std::vector<TIndexLink> fIndexLinkList; //!
+
+  std::vector<ExRootTreeBranch *> fWrittenBranches; //!
+
+  std::vector<Char_t> fVisited; //!
+  std::vector<Candidate *> fParticles; //!
 #endif
 
-  ClassDef(TreeWriter, 2)
+  Bool_t fFlat; //!
+  Bool_t fIndexLinks; //!
+
+  ClassDef(TreeWriter, 4)
 };
 
 #endif
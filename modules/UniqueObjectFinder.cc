@@ -51,7 +51,8 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
-UniqueObjectFinder::UniqueObjectFinder()
+UniqueObjectFinder::UniqueObjectFinder() :
+  fUseUniqueID(kFALSE), fUseLeafBitmap(kFALSE)
 {
 }
 
@@ -68,6 +69,10 @@ void UniqueObjectFinder::Init()
   // use GetUniqueID algorithm to find unique objects (faster than the default Overlaps method)
   fUseUniqueID = GetBool("UseUniqueID", false);
 
+  // mark the leaves of the accepted candidates in a bitmap over GetUniqueID
+  // (same result as the default Overlaps method, in linear time)
+  fUseLeafBitmap = GetBool("UseLeafBitmap", false);
+
   // import arrays with output from other modules
 
   ExRootConfParam param = GetParam("InputArray");
@@ -111,6 +116,12 @@ void UniqueObjectFinder::Process()
   TIterator *iterator;
   TObjArray *array;
 
+  if(fUseLeafBitmap && !fUseUniqueID)
+  {
+    ProcessLeafBitmap();
+    return;
+  }
+
   // loop over all input arrays
   for(itInputMap = fInputMap.begin(); itInputMap != fInputMap.end(); ++itInputMap)
   {
@@ -168,3 +179,98 @@ Bool_t UniqueObjectFinder::Unique(Candidate *candidate, vector<pair<TIterator *,
 }
 
 //------------------------------------------------------------------------------
+
+void UniqueObjectFinder::CollectLeaves(Candidate *candidate)
+{
+  TObjArray *array;
+  Int_t i, size;
+
+  // collect the unique IDs of all candidates without constituents,
+  // two candidates overlap if and only if they share one of them
+
+  fLeaves.clear();
+  fStack.clear();
+  fStack.push_back(candidate);
+
+  while(!fStack.empty())
+  {
+    candidate = fStack.back();
+    fStack.pop_back();
+
+    array = candidate->GetCandidates();
+    size = array->GetEntriesFast();
+    if(size == 0)
+    {
+      fLeaves.push_back(candidate->GetUniqueID() & 0xffffff);
+      continue;
+    }
+
+    for(i = 0; i < size; ++i)
+    {
+      fStack.push_back(static_cast<Candidate *>(array->At(i)));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void UniqueObjectFinder::ProcessLeafBitmap()
+{
+  Candidate *candidate;
+  vector<pair<TIterator *, TObjArray *> >::iterator itInputMap;
+  vector<UInt_t>::iterator itLeaves;
+  TIterator *iterator;
+  TObjArray *array;
+  Bool_t unique;
+
+  // reset the entries set during the previous event
+  for(itLeaves = fClaimedLeaves.begin(); itLeaves != fClaimedLeaves.end(); ++itLeaves)
+  {
+    fClaimed[*itLeaves] = 0;
+  }
+  fClaimedLeaves.clear();
+
+  // loop over all input arrays
+  for(itInputMap = fInputMap.begin(); itInputMap != fInputMap.end(); ++itInputMap)
+  {
+    iterator = itInputMap->first;
+    array = itInputMap->second;
+
+    // candidates are only compared with the previous arrays,
+    // so their leaves are claimed once the whole array is processed
+    fPendingLeaves.clear();
+
+    // loop over all candidates
+    iterator->Reset();
+    while((candidate = static_cast<Candidate *>(iterator->Next())))
+    {
+      CollectLeaves(candidate);
+
+      unique = kTRUE;
+      for(itLeaves = fLeaves.begin(); itLeaves != fLeaves.end(); ++itLeaves)
+      {
+        if(*itLeaves < fClaimed.size() && fClaimed[*itLeaves])
+        {
+          unique = kFALSE;
+          break;
+        }
+      }
+
+      if(unique)
+      {
+        array->Add(candidate);
+        fPendingLeaves.insert(fPendingLeaves.end(), fLeaves.begin(), fLeaves.end());
+      }
+    }
+
+    for(itLeaves = fPendingLeaves.begin(); itLeaves != fPendingLeaves.end(); ++itLeaves)
+    {
+      if(*itLeaves >= fClaimed.size()) fClaimed.resize(2 * (*itLeaves) + 1, 0);
+      if(fClaimed[*itLeaves]) continue;
+      fClaimed[*itLeaves] = 1;
+      fClaimedLeaves.push_back(*itLeaves);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
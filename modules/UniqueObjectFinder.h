@@ -48,9 +48,17 @@ public:
 
 private:
   Bool_t fUseUniqueID;
+  Bool_t fUseLeafBitmap;
 
   Bool_t Unique(Candidate *candidate, std::vector<std::pair<TIterator *, TObjArray *> >::iterator itInputMap);
 
+  void CollectLeaves(Candidate *candidate);
+  void ProcessLeafBitmap();
+
+  std::vector<Candidate *> fStack; //!
+  std::vector<UInt_t> fLeaves, fPendingLeaves, fClaimedLeaves; //!
+  std::vector<Char_t> fClaimed; //!
+
   std::vector<std::pair<TIterator *, TObjArray *> > fInputMap; //!
 
   ClassDef(UniqueObjectFinder, 1)
@@ -31,7 +31,6 @@
 
 #include <algorithm>
 #include <iostream>
-#include <map>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -45,6 +44,12 @@ static const Double_t ns = 1.;
 static const Double_t s = 1.e+9 * ns;
 static const Double_t c_light = 2.99792458e+8 * m / s;
 
+// jet grid used for the track-jet matching, with cells larger than the cone size
+static const Double_t kJetConeSize = 0.4;
+static const Double_t kGridEtaMax = 6.0;
+static const Int_t kEtaCells = 30;
+static const Int_t kPhiCells = 15;
+
 //------------------------------------------------------------------------------
 
 VertexSorter::VertexSorter() :
@@ -86,6 +91,8 @@ void VertexSorter::Init()
   fOutputArray = ExportArray(GetString("OutputArray", "clusters"));
 
   fMethod = GetString("Method", "BTV");
+
+  fJetGrid.resize(kEtaCells * kPhiCells);
 }
 
 //------------------------------------------------------------------------------
@@ -113,18 +120,33 @@ static Bool_t secondAscending(pair<UInt_t, Double_t> pair0, pair<UInt_t, Double_
 void VertexSorter::Process()
 {
   Candidate *candidate, *jetCandidate, *beamSpotCandidate;
-  map<Int_t, UInt_t> clusterIDToIndex;
-  map<Int_t, UInt_t>::const_iterator itClusterIDToIndex;
-  map<Int_t, Double_t> clusterIDToSumPT2;
-  map<Int_t, Double_t>::const_iterator itClusterIDToSumPT2;
   vector<pair<Int_t, Double_t> > sortedClusterIDs;
   vector<pair<Int_t, Double_t> >::const_iterator itSortedClusterIDs;
+  vector<const Candidate *>::const_iterator itJets;
+  Int_t iCluster, nClusters, minClusterID, maxClusterID, id, iEta, iPhi, i, j;
+  Double_t pt;
+  Bool_t isInJet;
+
+  // dense per-cluster arrays indexed by ClusterIndex - minClusterID,
+  // filled in a single pass over the clusters
+
+  nClusters = fInputArray->GetEntriesFast();
+  minClusterID = 0;
+  maxClusterID = -1;
+  for(iCluster = 0; iCluster < nClusters; ++iCluster)
+  {
+    const Candidate &cluster = *((Candidate *)fInputArray->At(iCluster));
+    if(iCluster == 0 || cluster.ClusterIndex < minClusterID) minClusterID = cluster.ClusterIndex;
+    if(iCluster == 0 || cluster.ClusterIndex > maxClusterID) maxClusterID = cluster.ClusterIndex;
+  }
 
-  for(Int_t iCluster = 0; iCluster < fInputArray->GetEntries(); iCluster++)
+  fClusterRow.assign(maxClusterID - minClusterID + 1, -1);
+  fClusterSumPT2.assign(maxClusterID - minClusterID + 1, 0.0);
+
+  for(iCluster = 0; iCluster < nClusters; ++iCluster)
   {
     const Candidate &cluster = *((Candidate *)fInputArray->At(iCluster));
-    clusterIDToIndex[cluster.ClusterIndex] = iCluster;
-    clusterIDToSumPT2[cluster.ClusterIndex] = 0.0;
+    fClusterRow[cluster.ClusterIndex - minClusterID] = iCluster;
   }
 
   if(fMethod == "BTV")
@@ -135,37 +157,58 @@ void VertexSorter::Process()
       throw 0;
     }
 
+    // fill an (eta, phi) grid of jets with cells larger than the
+    // matching cone, so that only the neighbouring cells are checked
+
+    for(i = 0; i < kEtaCells * kPhiCells; ++i) fJetGrid[i].clear();
+
+    fItJetInputArray->Reset();
+    while((jetCandidate = static_cast<Candidate *>(fItJetInputArray->Next())))
+    {
+      if(jetCandidate->Momentum.Pt() < 30.0)
+        continue;
+      fJetGrid[EtaCell(jetCandidate->Momentum.Eta()) * kPhiCells + PhiCell(jetCandidate->Momentum.Phi())].push_back(jetCandidate);
+    }
+
     fItTrackInputArray->Reset();
     while((candidate = static_cast<Candidate *>(fItTrackInputArray->Next())))
     {
-      if(candidate->Momentum.Pt() < 1.0)
+      pt = candidate->Momentum.Pt();
+      if(pt < 1.0)
         continue;
       if(candidate->ClusterIndex < 0)
         continue;
       TLorentzVector p(candidate->Momentum.Px(), candidate->Momentum.Py(), candidate->Momentum.Pz(), candidate->Momentum.E());
-      Bool_t isInJet = false;
+      isInJet = false;
 
-      fItJetInputArray->Reset();
-      while((jetCandidate = static_cast<Candidate *>(fItJetInputArray->Next())))
+      iEta = EtaCell(p.Eta());
+      iPhi = PhiCell(p.Phi());
+      for(i = TMath::Max(iEta - 1, 0); !isInJet && i <= TMath::Min(iEta + 1, kEtaCells - 1); ++i)
       {
-        if(jetCandidate->Momentum.Pt() < 30.0)
-          continue;
-        TLorentzVector q(jetCandidate->Momentum.Px(), jetCandidate->Momentum.Py(), jetCandidate->Momentum.Pz(), jetCandidate->Momentum.E());
-
-        if(p.DeltaR(q) > 0.4)
-          continue;
-        isInJet = true;
-        break;
+        for(j = iPhi - 1; !isInJet && j <= iPhi + 1; ++j)
+        {
+          const vector<const Candidate *> &jets = fJetGrid[i * kPhiCells + (j + kPhiCells) % kPhiCells];
+          for(itJets = jets.begin(); itJets != jets.end(); ++itJets)
+          {
+            TLorentzVector q((*itJets)->Momentum.Px(), (*itJets)->Momentum.Py(), (*itJets)->Momentum.Pz(), (*itJets)->Momentum.E());
+
+            if(p.DeltaR(q) > kJetConeSize)
+              continue;
+            isInJet = true;
+            break;
+          }
+        }
       }
       if(!isInJet)
         continue;
 
-      clusterIDToSumPT2.at(candidate->ClusterIndex) += candidate->Momentum.Pt() * candidate->Momentum.Pt();
+      id = candidate->ClusterIndex - minClusterID;
+      if(candidate->ClusterIndex > maxClusterID || id < 0 || fClusterRow[id] < 0)
+      {
+        throw runtime_error("track is associated to a cluster that is not in the input array");
+      }
+      fClusterSumPT2[id] += pt * pt;
     }
-
-    for(itClusterIDToSumPT2 = clusterIDToSumPT2.begin(); itClusterIDToSumPT2 != clusterIDToSumPT2.end(); ++itClusterIDToSumPT2)
-      sortedClusterIDs.push_back(make_pair(itClusterIDToSumPT2->first, itClusterIDToSumPT2->second));
-    sort(sortedClusterIDs.begin(), sortedClusterIDs.end(), secondDescending);
   }
   else if(fMethod == "GenClosest")
   {
@@ -181,7 +224,7 @@ void VertexSorter::Process()
     }
 
     beamSpotCandidate = (Candidate *)fBeamSpotInputArray->At(0);
-    for(Int_t iCluster = 0; iCluster < fInputArray->GetEntries(); iCluster++)
+    for(iCluster = 0; iCluster < nClusters; iCluster++)
     {
       const Candidate &cluster = *((Candidate *)fInputArray->At(iCluster));
       sortedClusterIDs.push_back(make_pair(cluster.ClusterIndex, fabs(cluster.Position.Z() - beamSpotCandidate->Position.Z())));
@@ -195,17 +238,12 @@ void VertexSorter::Process()
     {
       if(candidate->IsPU)
         continue;
-      for(itClusterIDToIndex = clusterIDToIndex.begin(); itClusterIDToIndex != clusterIDToIndex.end(); ++itClusterIDToIndex)
-      {
-        if(candidate->ClusterIndex != itClusterIDToIndex->first)
-          continue;
-        clusterIDToSumPT2.at(itClusterIDToIndex->first) += candidate->Momentum.Pt() * candidate->Momentum.Pt();
-      }
+      id = candidate->ClusterIndex - minClusterID;
+      if(candidate->ClusterIndex > maxClusterID || id < 0 || fClusterRow[id] < 0)
+        continue;
+      pt = candidate->Momentum.Pt();
+      fClusterSumPT2[id] += pt * pt;
     }
-
-    for(itClusterIDToSumPT2 = clusterIDToSumPT2.begin(); itClusterIDToSumPT2 != clusterIDToSumPT2.end(); ++itClusterIDToSumPT2)
-      sortedClusterIDs.push_back(make_pair(itClusterIDToSumPT2->first, itClusterIDToSumPT2->second));
-    sort(sortedClusterIDs.begin(), sortedClusterIDs.end(), secondDescending);
   }
   else
   {
@@ -216,9 +254,22 @@ void VertexSorter::Process()
     cout << "  GenBest" << endl;
     throw 0;
   }
+
+  if(fMethod == "BTV" || fMethod == "GenBest")
+  {
+    // clusters in increasing ClusterIndex order, as they were with a std::map,
+    // so that sort gives the same order for equal sums
+    for(id = 0; id <= maxClusterID - minClusterID; ++id)
+    {
+      if(fClusterRow[id] < 0) continue;
+      sortedClusterIDs.push_back(make_pair(id + minClusterID, fClusterSumPT2[id]));
+    }
+    sort(sortedClusterIDs.begin(), sortedClusterIDs.end(), secondDescending);
+  }
+
   for(itSortedClusterIDs = sortedClusterIDs.begin(); itSortedClusterIDs != sortedClusterIDs.end(); ++itSortedClusterIDs)
   {
-    Candidate *cluster = (Candidate *)fInputArray->At(clusterIDToIndex.at(itSortedClusterIDs->first));
+    Candidate *cluster = (Candidate *)fInputArray->At(fClusterRow[itSortedClusterIDs->first - minClusterID]);
     if(fMethod == "BTV")
       cluster->BTVSumPT2 = itSortedClusterIDs->second;
     else if(fMethod == "GenClosest")
@@ -230,3 +281,19 @@ void VertexSorter::Process()
 }
 
 //------------------------------------------------------------------------------
+
+Int_t VertexSorter::EtaCell(Double_t eta) const
+{
+  Int_t cell = TMath::FloorNint((eta + kGridEtaMax) / (2.0 * kGridEtaMax) * kEtaCells);
+  return TMath::Min(TMath::Max(cell, 0), kEtaCells - 1);
+}
+
+//------------------------------------------------------------------------------
+
+Int_t VertexSorter::PhiCell(Double_t phi) const
+{
+  Int_t cell = TMath::FloorNint((phi + TMath::Pi()) / (2.0 * TMath::Pi()) * kPhiCells);
+  return TMath::Min(TMath::Max(cell, 0), kPhiCells - 1);
+}
+
+//------------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 #include "classes/DelphesModule.h"
 
 #include <string>
+#include <vector>
 
 class TObjArray;
 class TIterator;
@@ -45,6 +46,13 @@ private:
 
   std::string fMethod;
 
+  Int_t EtaCell(Double_t eta) const;
+  Int_t PhiCell(Double_t phi) const;
+
+  std::vector<Int_t> fClusterRow; //!
+  std::vector<Double_t> fClusterSumPT2; //!
+  std::vector<std::vector<const Candidate *> > fJetGrid; //!
+
   ClassDef(VertexSorter, 1)
 };
 
@@ -1,5 +1,6 @@
 #! /usr/bin/env python
 import ROOT 
+import numpy
 from CPconfig import configuration
 
 def getArgSet(controlplots):
@@ -115,6 +116,16 @@ class BaseControlPlots:
       result["var3"] = 5.711
       return result
 
+    def processColumns(self, chunk):
+      """Columnar version of process, for a chunk of events (see ColumnarEvents). Must be overloaded for the columnar mode."""
+      raise NotImplementedError("%s has no columnar implementation" % type(self).__name__)
+      # that method must return a dictionnary name <-> (values, eventIndex) that matches self._h_vector,
+      # where eventIndex gives the event of each value, or is None for one value per event.
+      result = { }
+      result["var1"] = (chunk.jets.PT, chunk.jets.eventIndex())
+      result["var2"] = (chunk.jets.counts, None)
+      return result
+
     def setCategories(self, categories):
       """Set the categories, given a list of booleans. Only works for datasets"""
       if self._mode!="dataset": return
@@ -145,6 +156,19 @@ class BaseControlPlots:
       if self._ownedRDS:
         self._rds.add(self._obsSet)  
 
+    def fillColumns(self, data, mask, weights):
+      """Fills histograms with the values of the events selected by mask, given per-event weights."""
+      for name,(values,eventIndex) in data.items():
+        if eventIndex is None:
+          selected = mask
+          w = weights
+        else:
+          selected = mask[eventIndex]
+          w = weights[eventIndex]
+        x = numpy.ascontiguousarray(numpy.asarray(values)[selected], dtype=numpy.float64)
+        if len(x):
+          self._h_vector[name].FillN(len(x), x, numpy.ascontiguousarray(w[selected], dtype=numpy.float64))
+
     def fill(self, data, weight = 1.):
       """Fills whatever must be filled in"""
       if self._mode=="plots":
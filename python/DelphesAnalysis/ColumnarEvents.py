@@ -0,0 +1,179 @@
+import numpy
+from inspect import getargspec
+from ROOT import TChain
+from collections import Iterable
+from types import StringTypes
+from os import path
+
+class Collection(object):
+   """A jagged collection for a chunk of events.
+      The elements of all events are stored in flat NumPy arrays, one per field.
+      counts[i] is the number of elements of event i, and the elements of
+      event i are at positions offsets[i] to offsets[i+1] in the flat arrays.
+      Fields are read on first access, e.g. muons.PT"""
+
+   def __init__(self, counts, loader=None):
+     self.counts  = numpy.asarray(counts, dtype=numpy.int64)
+     self.offsets = numpy.zeros(len(self.counts)+1, dtype=numpy.int64)
+     numpy.cumsum(self.counts, out=self.offsets[1:])
+     self._loader = loader
+     self._fields = { }
+
+   def __len__(self):
+     """Number of events"""
+     return len(self.counts)
+
+   def __getattr__(self, name):
+     """Flat array of a field, read on demand."""
+     if name[0]=='_':
+       raise AttributeError("%r object has no attribute %r" % (type(self).__name__, name))
+     if not name in self._fields:
+       if self._loader is None:
+         raise AttributeError("%r object has no field %r" % (type(self).__name__, name))
+       self._fields[name] = self._loader(name)
+     return self._fields[name]
+
+   def eventIndex(self):
+     """Event of each element, as a flat array."""
+     return numpy.repeat(numpy.arange(len(self.counts)), self.counts)
+
+   def leading(self, name, default=0.):
+     """Per-event value of the field for the first element, default for empty events."""
+     values = getattr(self, name)
+     output = numpy.full(len(self.counts), default, dtype=numpy.float64)
+     filled = self.counts>0
+     output[filled] = values[self.offsets[:-1][filled]]
+     return output
+
+   def select(self, mask):
+     """New collection with the elements for which the flat mask is true."""
+     mask = numpy.asarray(mask, dtype=bool)
+     counts = numpy.bincount(self.eventIndex()[mask], minlength=len(self.counts))
+     return Collection(counts, lambda name: getattr(self, name)[mask])
+
+class EventChunk(object):
+   """A chunk of consecutive events.
+      Collections and products are accessed as attributes and computed on first use,
+      like for AnalysisEvent, but each of them holds arrays for all the events of the chunk."""
+
+   def __init__(self, events, start, size):
+     self._events = events
+     self.start = start
+     self.size = size
+
+   def __len__(self):
+     return self.size
+
+   def weight(self, weightList=None, **kwargs):
+     """Per-event weights, see ColumnarEvents.weight"""
+     return self._events.weight(self, weightList, **kwargs)
+
+   def __getattr__(self, name):
+     if name[0]=='_':
+       raise AttributeError("%r object has no attribute %r" % (type(self).__name__, name))
+     value = self._events.produce(self, name)
+     self.__dict__[name] = value
+     return value
+
+class ColumnarEvents(object):
+   """Columnar counterpart of AnalysisEvent.
+      The Delphes tree is read in chunks of chunkSize events. For each chunk,
+      collections are read into NumPy arrays with per-event counts (see Collection),
+      and producers and weight engines work on the whole chunk at once.
+      Columnar producers take a chunk and return arrays or collections,
+      columnar weight engines have a weightColumns method returning per-event weights."""
+
+   def __init__(self, inputFiles = '', chunkSize=100000, maxEvents=0):
+     self._chain = TChain("Delphes","Delphes")
+     if isinstance(inputFiles,Iterable) and not isinstance(inputFiles,StringTypes):
+       files = inputFiles
+     elif isinstance(inputFiles,StringTypes):
+       files = [ inputFiles ]
+     else:
+       print "Warning: invalid inputFiles"
+       files = [ ]
+     for thefile in files:
+       if path.isfile(thefile):
+         self._chain.AddFile(thefile)
+       else:
+         print "Warning: ",thefile," do not exist."
+     self._chunkSize     = chunkSize
+     self._maxEvents     = maxEvents
+     self._collections   = { }
+     self._producers     = { }
+     self._weightEngines = { }
+     self._branches = set(map(lambda b:b.GetName(),self._chain.GetListOfBranches()))
+
+   def addCollection(self, name, inputTag):
+     """Register an event collection as used by the analysis."""
+     if name in self._collections or name in self._producers:
+       raise KeyError("%r is already declared" % name)
+     if inputTag not in self._branches:
+       raise AttributeError("%r object has no branch %r" % (type(self).__name__, inputTag))
+     self._collections[name] = inputTag
+
+   def addProducer(self, name, producer, **kwargs):
+     """Register a columnar producer, called as producer(chunk, **kwargs)."""
+     if name in self._collections or name in self._producers:
+       raise KeyError("%r is already declared" % name)
+     self._producers[name] = (producer,kwargs)
+
+   def addWeight(self, name, weightClass):
+     """Declare a weight engine. weightClass must have a weightColumns method returning per-event weights."""
+     if name in self._weightEngines:
+       raise KeyError("%s weight engine is already declared" % name)
+     if not hasattr(weightClass,"weightColumns"):
+       raise AttributeError("%s weight engine has no weightColumns method" % name)
+     self._weightEngines[name] = weightClass
+
+   def entries(self):
+     """Number of events to process"""
+     entries = self._chain.GetEntries()
+     if self._maxEvents > 0:
+       entries = min(entries, self._maxEvents)
+     return entries
+
+   def __iter__(self):
+     """Iterator over chunks of events"""
+     entries = self.entries()
+     for start in xrange(0, entries, self._chunkSize):
+       yield EventChunk(self, start, min(self._chunkSize, entries-start))
+
+   def weight(self, chunk, weightList=None, **kwargs):
+     """Per-event weights: product of the selected engines, all by default."""
+     if weightList is None:
+       weightList = self._weightEngines.keys()
+     kwargs["weightList"] = weightList
+     w = numpy.ones(chunk.size)
+     for weightElement in weightList:
+       engine = self._weightEngines[weightElement]
+       engineArgs = getargspec(engine.weightColumns).args
+       subargs = dict((k,v) for k,v in kwargs.iteritems() if k in engineArgs)
+       w *= engine.weightColumns(chunk, **subargs)
+     return w
+
+   def produce(self, chunk, name):
+     """Read a collection or run a producer for a chunk."""
+     if name in self._collections:
+       branch = self._collections[name]
+       counts = self._draw(branch+"_size", chunk.start, chunk.size, chunk.size)
+       rows = int(counts.sum())
+       return Collection(counts, lambda field: self._draw(branch+"."+field, chunk.start, chunk.size, rows))
+     if name in self._producers:
+       return self._producers[name][0](chunk, **self._producers[name][1])
+     raise AttributeError("%r object has no attribute %r" % (type(chunk).__name__, name))
+
+   def _draw(self, expression, start, size, rows):
+     """Evaluate expression for the events [start, start+size) into a flat array, using TTree::Draw"""
+     if rows == 0:
+       return numpy.zeros(0)
+     self._chain.SetEstimate(rows+1)
+     selected = self._chain.Draw(expression, "", "goff", size, start)
+     if selected < 0:
+       raise RuntimeError("can't evaluate %s" % expression)
+     buffer = self._chain.GetV1()
+     try:
+       buffer.SetSize(selected)
+     except AttributeError:
+       buffer.reshape((selected,))
+     return numpy.array(numpy.frombuffer(buffer, dtype=numpy.float64, count=selected))
@@ -27,6 +27,12 @@ parser.add_option("--Njobs", type="int", dest='Njobs', default="1",
                   help="Number of jobs when splitting the processing.")
 parser.add_option("--jobNumber", type="int", dest='jobNumber', default="0",
                   help="Number of the job is a splitted set of jobs.")
+parser.add_option("--columnar",action="store_true",dest="columnar",
+                  help="Process chunks of events as NumPy arrays (needs columnar implementations).")
+parser.add_option("--chunkSize", type="int", dest='chunkSize', default="100000",
+                  help="Number of events per chunk in columnar mode.")
+parser.add_option("--processes", type="int", dest='processes', default="1",
+                  help="Number of local processes in columnar mode, each processing a subset of the files.")
 
 (options, args) = parser.parse_args()
 
@@ -45,12 +51,15 @@ if options.outputname is None:
 import Delphes
 import ROOT
 import itertools
+import numpy
 import time
 from importlib import import_module
 from AnalysisEvent import AnalysisEvent
 from BaseControlPlots import getArgSet
 import EventSelection
 import cProfile
+import multiprocessing
+from ColumnarEvents import ColumnarEvents
 
 def main(options):
   """simplistic program main"""
@@ -85,17 +94,26 @@ def main(options):
     print "Error: jobNumber must be strictly smaller than Njobs."
     parser.print_help()
     return
+  if options.columnar and configuration.runningMode!="plots":
+    print "Error: columnar mode only produces plots."
+    return
+  if options.chunkSize<1 or options.processes<1:
+    print "Error: chunkSize and processes must be strictly positive."
+    parser.print_help()
+    return
   # if all ok, run the procedure
-  runAnalysis(path=options.path,outputname=options.outputname, levels=levels, Njobs=options.Njobs, jobNumber=options.jobNumber)
+  if options.columnar:
+    runColumnarAnalysis(path=options.path,outputname=options.outputname, levels=levels, Njobs=options.Njobs, jobNumber=options.jobNumber,
+                        chunkSize=options.chunkSize, processes=options.processes)
+  else:
+    runAnalysis(path=options.path,outputname=options.outputname, levels=levels, Njobs=options.Njobs, jobNumber=options.jobNumber)
 
 #######################################################################################
 ### Central Routine: manage input/output, loop on events, manage weights and plots  ###
 #######################################################################################
 
-def runAnalysis(path, levels, outputname="controlPlots.root", Njobs=1, jobNumber=1):
-  """produce all the plots in one go"""
-
-  # inputs
+def inputFiles(path, Njobs=1, jobNumber=0):
+  """list of input files for this job"""
   if os.path.isdir(path):
     dirList=list(itertools.islice(os.listdir(path), jobNumber, None, Njobs))
     files=[]
@@ -105,6 +123,13 @@ def runAnalysis(path, levels, outputname="controlPlots.root", Njobs=1, jobNumber
     files=[path]
   else:
     files=[]
+  return files
+
+def runAnalysis(path, levels, outputname="controlPlots.root", Njobs=1, jobNumber=1):
+  """produce all the plots in one go"""
+
+  # inputs
+  files = inputFiles(path, Njobs, jobNumber)
 
   # output
   output = ROOT.TFile(outputname, "RECREATE")
@@ -193,6 +218,82 @@ def runAnalysis(path, levels, outputname="controlPlots.root", Njobs=1, jobNumber
   # close the file
   output.Close()
 
+#######################################################################################
+### Columnar Routine: chunks of events as NumPy arrays, optional process pool       ###
+#######################################################################################
+
+def runColumnarAnalysis(path, levels, outputname="controlPlots.root", Njobs=1, jobNumber=0, chunkSize=100000, processes=1):
+  """produce all the plots in one go, processing chunks of events as arrays"""
+  files = inputFiles(path, Njobs, jobNumber)
+  processes = min(processes, len(files))
+  if processes<=1:
+    processColumnarFiles((files, levels, outputname, chunkSize))
+    return
+
+  # each process writes its own file, merged at the end
+  parts = [ "%s.part%d" % (outputname, i) for i in range(processes) ]
+  jobs = [ (files[i::processes], levels, parts[i], chunkSize) for i in range(processes) ]
+  pool = multiprocessing.Pool(processes)
+  pool.map(processColumnarFiles, jobs)
+  pool.close()
+  pool.join()
+
+  merger = ROOT.TFileMerger(False)
+  merger.OutputFile(outputname, "RECREATE")
+  for part in parts:
+    merger.AddFile(part)
+  merger.Merge()
+  for part in parts:
+    os.remove(part)
+
+def processColumnarFiles(job):
+  """columnar processing of a list of files into one output file"""
+  files, levels, outputname, chunkSize = job
+
+  # output
+  output = ROOT.TFile(outputname, "RECREATE")
+
+  # chunk iterator, plus configuration of standard collections and producers
+  events = ColumnarEvents(files, chunkSize)
+  EventSelection.prepareColumnarEvents(events)
+
+  # prepare and book the plots
+  controlPlots=[]
+  leafList = [None]*EventSelection.eventCategories()
+  createDirectory(EventSelection.categoriesHierarchy(), output, leafList)
+  for levelDir in leafList:
+    levelPlots=[]
+    for cp in configuration.controlPlots:
+      levelPlots.append(getattr(import_module(cp.module),cp.classname)(dir=levelDir.mkdir(cp.label),mode="plots"))
+    controlPlots.append(levelPlots)
+  for level in levels:
+    for conf,cp in zip(configuration.controlPlots,controlPlots[level]):
+      cp.beginJob(**conf.kwargs)
+
+  # process chunks
+  t0 = time.time()
+  for chunk in events:
+    print "Processing... events %d to %d. Last chunk in %f s." % (chunk.start,chunk.start+chunk.size-1,(time.time()-t0))
+    t0 = time.time()
+    categoryData = chunk.category
+    # process the chunk once (for the first level)
+    selectionPlotsData = [ cp.processColumns(chunk) for cp in controlPlots[levels[0]] ]
+    # fill the histograms with the events of each level
+    for level in levels:
+      mask = numpy.asarray(EventSelection.isInCategoryColumns(level, categoryData), dtype=bool)
+      if not mask.any(): continue
+      weights = chunk.weight(category=level)
+      for cp, data in zip(controlPlots[level],selectionPlotsData):
+        cp.fillColumns(data, mask, weights)
+
+  # save all
+  for level in levels:
+    for cp in controlPlots[level]:
+      cp.endJob()
+
+  # close the file
+  output.Close()
+
 def createDirectory(dirStructure, directory, leafList):
   """Recursively creates the directories for the various stages"""
   for key,item in dirStructure.iteritems():
@@ -28,6 +28,12 @@ categoryNames  = EventSelectionImplementation.categoryNames
 eventCategory  = EventSelectionImplementation.eventCategory
 isInCategory   = EventSelectionImplementation.isInCategory
 
+# optional columnar implementation, working on arrays for a chunk of events (see ColumnarEvents):
+# - eventCategoryColumns (category data producer, list of per-event arrays)
+# - isInCategoryColumns (category definition, per-event boolean array)
+eventCategoryColumns = getattr(EventSelectionImplementation, "eventCategoryColumns", None)
+isInCategoryColumns  = getattr(EventSelectionImplementation, "isInCategoryColumns", None)
+
 # Functions below should not be touched in any implementation.
 
 def eventCategories():
@@ -59,3 +65,18 @@ def prepareAnalysisEvent(event):
   for weight in configuration.eventWeights:
     events.addWeight(weight.label,getattr(import_module(weight.module),weight.classname)(**weight.kwargs))
 
+
+def prepareColumnarEvents(events):
+  """Define collections and producers for the columnar mode.
+     Each producer function must have a columnar version with the Columns suffix."""
+  if isInCategoryColumns is None:
+    raise NotImplementedError("%s has no columnar implementation" % configuration.eventSelection)
+  for coll in configuration.eventCollections:
+    events.addCollection(coll.label,coll.collection)
+  for prod in configuration.eventProducers:
+    module = import_module(prod.module)
+    if not hasattr(module, prod.function+"Columns"):
+      raise NotImplementedError("%s.%s has no columnar implementation" % (prod.module, prod.function))
+    events.addProducer(prod.label,getattr(module,prod.function+"Columns"),**prod.kwargs)
+  for weight in configuration.eventWeights:
+    events.addWeight(weight.label,getattr(import_module(weight.module),weight.classname)(**weight.kwargs))
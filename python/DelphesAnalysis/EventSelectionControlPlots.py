@@ -1,4 +1,5 @@
 import ROOT
+import numpy
 import sys
 import os
 from AnalysisEvent import AnalysisEvent
@@ -35,6 +36,21 @@ class EventSelectionControlPlots(BaseControlPlots):
       result["event"] = event.event()
       return result
 
+    def processColumns(self, chunk):
+      """EventSelectionControlPlots, columnar version"""
+      result = { }
+      ## event category
+      categoryData = chunk.category
+      values = [ ]
+      events = [ ]
+      for category in range(self.eventCategories):
+        selected = numpy.nonzero(EventSelection.isInCategoryColumns(category, categoryData))[0]
+        values.append(numpy.full(len(selected), category))
+        events.append(selected)
+      result["category"] = (numpy.concatenate(values), numpy.concatenate(events))
+      result["event"] = (chunk.genEvent.Number, None)
+      return result
+
 if __name__=="__main__":
   import sys
   from BaseControlPlots import runTest
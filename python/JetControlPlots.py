@@ -50,6 +50,23 @@ class JetControlPlots(BaseControlPlots):
       result["METphi"] = event.MEt[0].Phi
       return result
 
+    def processColumns(self, chunk):
+      #get information for a chunk of events
+      result = { }
+      jets = chunk.selectedJets
+      bjets = jets.select(jets.BTag!=0)
+      result["JetPt"] = (jets.PT, jets.eventIndex())
+      result["JetEta"] = (jets.Eta, jets.eventIndex())
+      result["JetPhi"] = (jets.Phi, jets.eventIndex())
+      result["BjetPt"] = (bjets.PT, bjets.eventIndex())
+      result["BjetEta"] = (bjets.Eta, bjets.eventIndex())
+      result["BjetPhi"] = (bjets.Phi, bjets.eventIndex())
+      result["Njets"]  = (jets.counts, None)
+      result["Nbjets"] = (bjets.counts, None)
+      result["MET"] = (chunk.MEt.leading("MET"), None)
+      result["METphi"] = (chunk.MEt.leading("Phi"), None)
+      return result
+
 if __name__=="__main__":
   import sys
   from DelphesAnalysis.BaseControlPlots import runTest
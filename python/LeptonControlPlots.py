@@ -37,6 +37,17 @@ class LeptonControlPlots(BaseControlPlots):
       result["NElectrons"] = event.electrons.GetEntries()
       return result
 
+    def processColumns(self, chunk):
+      #get information for a chunk of events
+      result = { }
+      result["MuonPt"] = (chunk.muons.PT, chunk.muons.eventIndex())
+      result["MuonEta"] = (chunk.muons.Eta, chunk.muons.eventIndex())
+      result["ElectronPt"] = (chunk.electrons.PT, chunk.electrons.eventIndex())
+      result["ElectronEta"] = (chunk.electrons.Eta, chunk.electrons.eventIndex())
+      result["NMuons"] = (chunk.muons.counts, None)
+      result["NElectrons"] = (chunk.electrons.counts, None)
+      return result
+
 if __name__=="__main__":
   import sys
   from DelphesAnalysis.BaseControlPlots import runTest
@@ -9,6 +9,8 @@
 #   event.electrons
 #   event.jets
 
+import numpy
+
 # the list of category names
 categoryNames = [ "MuonChannel/SingleMuon", "ElectronChannel/SingleElectron", "ElectronChannel/Jet", "MuonChannel/DoubleMuon", "ElectronChannel/DoubleElectron" ]
 
@@ -36,6 +38,22 @@ def eventCategory(event):
   # DONE
   return categoryData
 
+def eventCategoryColumns(chunk):
+  """Columnar version of eventCategory: one array per item, for a chunk of events"""
+  categoryData = [ ]
+  # 0: number of muons
+  categoryData.append(chunk.muons.counts)
+  # 1: number of electrons
+  categoryData.append(chunk.electrons.counts)
+  # 2: number of jets
+  categoryData.append(chunk.jets.counts)
+  # 3: Pt of the leading muon > 2GeV
+  categoryData.append(chunk.muons.leading("PT")>1.)
+  # 4: Pt of the leading electron > 2 GeV
+  categoryData.append(chunk.electrons.leading("PT")>1.)
+  # DONE
+  return categoryData
+
 def isInCategory(category, categoryData):
   """Check if the event enters category X, given the tuple computed by eventCategory."""
   if category==0:
@@ -51,3 +69,18 @@ def isInCategory(category, categoryData):
   else:
     return False
 
+
+def isInCategoryColumns(category, categoryData):
+  """Columnar version of isInCategory: per-event boolean array."""
+  if category==0:
+    return categoryData[0]>0 
+  elif category==1:
+    return categoryData[1]>0
+  elif category==2:
+    return categoryData[2]>0
+  elif category==3:
+    return isInCategoryColumns(0,categoryData) & (categoryData[3]==True)
+  elif category==4:
+    return isInCategoryColumns(1,categoryData) & (categoryData[4]==True)
+  else:
+    return numpy.zeros(len(categoryData[0]),dtype=bool)
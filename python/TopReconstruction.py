@@ -1,4 +1,5 @@
 from itertools import combinations
+from ColumnarEvents import Collection
 
 def jetSelection(event, ptcut=20., etacut=2.4):
   def jetfilter(jet): return jet.PT>ptcut and abs(jet.Eta)<etacut
@@ -55,3 +56,29 @@ def topCandidates(event,leptonic=True,hadronic=True):
       return abs(mass-172.9)
     return sorted(output,key=massDistance)
 
+
+# columnar versions, for a chunk of events (see ColumnarEvents)
+
+def jetSelectionColumns(chunk, ptcut=20., etacut=2.4):
+  jets = chunk.jets
+  return jets.select((jets.PT>ptcut) & (abs(jets.Eta)<etacut))
+
+def bjetsColumns(chunk):
+  jets = chunk.selectedJets
+  return jets.select(jets.BTag!=0)
+
+def ljetsColumns(chunk):
+  jets = chunk.selectedJets
+  return jets.select(jets.BTag==0)
+
+def topCandidatesColumns(chunk,leptonic=True,hadronic=True):
+  """Number of candidates per event, as a collection without fields"""
+  nleptons = chunk.electrons.counts + chunk.muons.counts
+  nl = chunk.lJets.counts
+  nb = chunk.bJets.counts
+  if leptonic and not hadronic:
+    return Collection(nb*nleptons)
+  if hadronic and not leptonic:
+    return Collection(nl*(nl-1)//2*nb)
+  if hadronic and leptonic:
+    return Collection(nl*(nl-1)//2*nb*(nb-1)//2*nleptons)
@@ -10,6 +10,8 @@
 #   event.topCandidates_H
 #   event.topPairCandidates
 
+import numpy
+
 # the list of category names
 categoryNames = [ "l4j", "withPtCuts", "withBtag", "LeptonicTopCandidate", "HadronicTopCandidate", "TtbarCandidate" ]
 
@@ -47,6 +49,32 @@ def eventCategory(event):
   # DONE
   return categoryData
 
+def eventCategoryColumns(chunk):
+  """Columnar version of eventCategory: one array per item, for a chunk of events"""
+  categoryData = [ ]
+  # 0: number of muons
+  categoryData.append(chunk.muons.counts)
+  # 1: number of electrons
+  categoryData.append(chunk.electrons.counts)
+  # 2: number of jets
+  categoryData.append(chunk.jets.counts)
+  # 3: Pt of the leading muon 
+  categoryData.append(chunk.muons.leading("PT"))
+  # 4: Pt of the leading electron 
+  categoryData.append(chunk.electrons.leading("PT"))
+  # 5: number of selected jets
+  categoryData.append(chunk.selectedJets.counts)
+  # 6: number of bjets
+  categoryData.append(chunk.bJets.counts)
+  # 7: leptonic top candidate
+  categoryData.append(chunk.topCandidates_L.counts)
+  # 8: hadronic top candidate
+  categoryData.append(chunk.topCandidates_H.counts)
+  # 9: top pairs
+  categoryData.append(chunk.topPairCandidates.counts)
+  # DONE
+  return categoryData
+
 def isInCategory(category, categoryData):
   """Check if the event enters category X, given the tuple computed by eventCategory."""
   if category==0:
@@ -64,3 +92,20 @@ def isInCategory(category, categoryData):
   else:
     return False
 
+
+def isInCategoryColumns(category, categoryData):
+  """Columnar version of isInCategory: per-event boolean array."""
+  if category==0:
+    return ((categoryData[0]>0) | (categoryData[1]>0)) & (categoryData[2]>=4)
+  elif category==1:
+    return isInCategoryColumns(0,categoryData) & ((categoryData[3]>15) | (categoryData[4]>15)) & (categoryData[5]>=4)
+  elif category==2:
+    return isInCategoryColumns(1,categoryData) & (categoryData[6]>=2)
+  elif category==3:
+    return isInCategoryColumns(2,categoryData) & (categoryData[7]>0)
+  elif category==4:
+    return isInCategoryColumns(2,categoryData) & (categoryData[8]>0)
+  elif category==5:
+    return isInCategoryColumns(2,categoryData) & (categoryData[9]>0)
+  else:
+    return numpy.zeros(len(categoryData[0]),dtype=bool)
@@ -32,9 +32,12 @@
 #include "TParticlePDG.h"
 #include "TStopwatch.h"
 
+#include "classes/DelphesCheckpoint.h"
 #include "classes/DelphesClasses.h"
+#include "classes/DelphesEventIndex.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesHepMC2Reader.h"
+#include "classes/DelphesParticleCacheWriter.h"
 #include "modules/Delphes.h"
 
 #include "ExRootAnalysis/ExRootProgressBar.h"
@@ -68,7 +71,15 @@ int main(int argc, char *argv[])
   DelphesFactory *factory = 0;
   TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
   DelphesHepMC2Reader *reader = 0;
-  Int_t i, maxEvents, skipEvents;
+  DelphesParticleCacheWriter *cacheWriter = 0;
+  const char *cacheFileName;
+  DelphesEventIndex *eventIndex = 0;
+  DelphesCheckpoint *checkpoint = 0;
+  const char *checkpointName;
+  TString indexName;
+  Bool_t useIndex, indexing;
+  Long64_t offset, eventOffset, checkpointInterval;
+  Int_t i, j, maxEvents, skipEvents;
   Long64_t length, eventCounter;
 
   if(argc < 3)
@@ -122,6 +133,33 @@ int main(int argc, char *argv[])
       throw runtime_error("SkipEvents must be zero or positive");
     }
 
+    // store the generator-level particles of the processed events in
+    // a binary particle cache that can be re-read with DelphesParticleCache
+    cacheFileName = confReader->GetString("::ParticleCacheFile", "");
+    if(cacheFileName[0] != '\0')
+    {
+      cacheWriter = new DelphesParticleCacheWriter(cacheFileName);
+    }
+
+    // keep the byte offsets of the events in input_file.index,
+    // so that SkipEvents seeks directly to the first requested event
+    useIndex = confReader->GetBool("::EventIndex", false);
+    eventIndex = new DelphesEventIndex;
+
+    // save the input position and the random generator state every
+    // CheckpointInterval events and when interrupted, and resume from there
+    checkpointName = confReader->GetString("::CheckpointFile", "");
+    checkpointInterval = confReader->GetInt("::CheckpointInterval", 1000);
+    if(checkpointName[0] != '\0')
+    {
+      checkpoint = new DelphesCheckpoint(checkpointName);
+    }
+
+    if(checkpointInterval <= 0)
+    {
+      throw runtime_error("CheckpointInterval must be positive");
+    }
+
     modularDelphes = new Delphes("Delphes");
     modularDelphes->SetConfReader(confReader);
     modularDelphes->SetTreeWriter(treeWriter);
@@ -136,6 +174,18 @@ int main(int argc, char *argv[])
     modularDelphes->InitTask();
 
     i = 3;
+
+    if(checkpoint && checkpoint->ReadCheckpoint())
+    {
+      i = checkpoint->GetInput();
+      if(i < 3 || i >= argc)
+      {
+        throw runtime_error("checkpoint does not match the input files");
+      }
+      checkpoint->RestoreRandom();
+      cout << "** Resuming after event " << checkpoint->GetEventCounter() << endl;
+    }
+
     do
     {
       if(interrupted) break;
@@ -178,6 +228,49 @@ int main(int argc, char *argv[])
       treeWriter->Clear();
       modularDelphes->Clear();
       reader->Clear();
+
+      offset = 0;
+      indexing = kFALSE;
+      if(inputFile != stdin)
+      {
+        indexName = TString(argv[i]) + ".index";
+        if(useIndex) indexing = !eventIndex->ReadIndex(indexName, length);
+
+        if(checkpoint && checkpoint->GetInput() == i)
+        {
+          offset = checkpoint->GetOffset();
+          eventCounter = checkpoint->GetEventCounter();
+        }
+        else if(useIndex && skipEvents > 0)
+        {
+          if(indexing)
+          {
+            eventIndex->BuildIndex(inputFile, "E ");
+            eventIndex->WriteIndex(indexName, length);
+            indexing = kFALSE;
+          }
+          if(!indexing && skipEvents < eventIndex->GetEntries())
+          {
+            offset = eventIndex->GetOffset(skipEvents);
+            eventCounter = skipEvents;
+          }
+        }
+      }
+
+      if(offset > 0)
+      {
+        // read the file header and the first event to set up the reader,
+        // then jump directly to the requested event
+        while(reader->ReadBlock(factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray) && !reader->EventReady()) continue;
+        modularDelphes->Clear();
+        reader->Clear();
+        fseeko(inputFile, offset, SEEK_SET);
+        indexing = kFALSE;
+      }
+
+      if(indexing) eventIndex->Clear();
+      eventOffset = offset;
+
       readStopWatch.Start();
       while((maxEvents <= 0 || eventCounter - skipEvents < maxEvents) && reader->ReadBlock(factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray) && !interrupted)
       {
@@ -185,10 +278,16 @@ int main(int argc, char *argv[])
         {
           ++eventCounter;
 
+          // offset of the event and of the position after it
+          if(indexing) eventIndex->AddEntry(eventOffset);
+          if(inputFile != stdin) eventOffset = ftello(inputFile);
+
           readStopWatch.Stop();
 
           if(eventCounter > skipEvents)
           {
+            if(cacheWriter) cacheWriter->WriteParticles(allParticleOutputArray, stableParticleOutputArray, partonOutputArray);
+
             procStopWatch.Start();
             modularDelphes->ProcessTask();
             procStopWatch.Stop();
@@ -196,9 +295,25 @@ int main(int argc, char *argv[])
             reader->AnalyzeEvent(branchEvent, eventCounter, &readStopWatch, &procStopWatch);
             reader->AnalyzeWeight(branchWeight);
 
-            treeWriter->Fill();
+            if(cacheWriter)
+            {
+              cacheWriter->WriteEvent(static_cast<HepMCEvent *>(branchEvent->At(0)));
+              for(j = 0; j < branchWeight->GetSize(); ++j)
+              {
+                cacheWriter->WriteWeight(j, static_cast<Weight *>(branchWeight->At(j))->Weight);
+              }
+              cacheWriter->WriteEntry();
+            }
+
+            if(!modularDelphes->IsEventRejected()) treeWriter->Fill();
 
             treeWriter->Clear();
+
+            if(checkpoint && inputFile != stdin && (eventCounter - skipEvents) % checkpointInterval == 0)
+            {
+              treeWriter->Flush();
+              checkpoint->WriteCheckpoint(i, eventOffset, eventCounter);
+            }
           }
 
           modularDelphes->Clear();
@@ -209,6 +324,17 @@ int main(int argc, char *argv[])
         progressBar.Update(ftello(inputFile), eventCounter);
       }
 
+      if(checkpoint && interrupted && inputFile != stdin)
+      {
+        checkpoint->WriteCheckpoint(i, eventOffset, eventCounter);
+      }
+
+      // the index is complete only if the whole file has been read
+      if(indexing && !interrupted && (maxEvents <= 0 || eventCounter - skipEvents < maxEvents))
+      {
+        eventIndex->WriteIndex(indexName, length);
+      }
+
       fseek(inputFile, 0L, SEEK_END);
       progressBar.Update(ftello(inputFile), eventCounter, kTRUE);
       progressBar.Finish();
@@ -221,8 +347,15 @@ int main(int argc, char *argv[])
     modularDelphes->FinishTask();
     treeWriter->Write();
 
+    if(checkpoint && !interrupted) checkpoint->RemoveCheckpoint();
+
+    if(cacheWriter) cacheWriter->WriteIndex();
+
     cout << "** Exiting..." << endl;
 
+    delete checkpoint;
+    delete eventIndex;
+    delete cacheWriter;
     delete reader;
     delete modularDelphes;
     delete confReader;
@@ -233,6 +366,7 @@ int main(int argc, char *argv[])
   }
   catch(runtime_error &e)
   {
+    if(cacheWriter) delete cacheWriter;
     if(treeWriter) delete treeWriter;
     if(outputFile) delete outputFile;
     cerr << "** ERROR: " << e.what() << endl;
@@ -0,0 +1,356 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <signal.h>
+#include <string.h>
+
+#include "TApplication.h"
+#include "TROOT.h"
+
+#include "TFile.h"
+#include "TObjArray.h"
+#include "TRandom3.h"
+#include "TStopwatch.h"
+
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+#include "classes/DelphesHepMC2Reader.h"
+#include "modules/Delphes.h"
+
+#include "ExRootAnalysis/ExRootConfReader.h"
+#include "ExRootAnalysis/ExRootProgressBar.h"
+#include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeWriter.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+// one detector configuration: its own Delphes instance, output file
+// and random number generator, so that each card gives the same result
+// as a separate DelphesHepMC2 run on the same input
+struct DelphesInstance
+{
+  TFile *outputFile;
+  ExRootTreeWriter *treeWriter;
+  ExRootTreeBranch *branchEvent, *branchWeight;
+  ExRootConfReader *confReader;
+  Delphes *modularDelphes;
+  DelphesFactory *factory;
+  TObjArray *allParticleOutputArray, *stableParticleOutputArray, *partonOutputArray;
+  TRandom *random;
+};
+
+//---------------------------------------------------------------------------
+
+void CopyParticles(TObjArray *allParticleInputArray,
+  TObjArray *stableParticleInputArray,
+  TObjArray *partonInputArray,
+  DelphesInstance *instance)
+{
+  Candidate *candidate, *particle;
+  Int_t i, stable, parton;
+
+  // the reader adds stable particles and partons in the same order
+  // as all particles, so that the membership is found in a single pass
+  stable = 0;
+  parton = 0;
+  for(i = 0; i < allParticleInputArray->GetEntriesFast(); ++i)
+  {
+    candidate = static_cast<Candidate *>(allParticleInputArray->At(i));
+
+    particle = instance->factory->NewCandidate();
+    candidate->Copy(*particle);
+
+    instance->allParticleOutputArray->Add(particle);
+
+    if(stable < stableParticleInputArray->GetEntriesFast() && stableParticleInputArray->At(stable) == candidate)
+    {
+      instance->stableParticleOutputArray->Add(particle);
+      ++stable;
+    }
+
+    if(parton < partonInputArray->GetEntriesFast() && partonInputArray->At(parton) == candidate)
+    {
+      instance->partonOutputArray->Add(particle);
+      ++parton;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static bool interrupted = false;
+
+void SignalHandler(int sig)
+{
+  interrupted = true;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "DelphesHepMC2MultiCard";
+  stringstream message;
+  FILE *inputFile = 0;
+  TStopwatch readStopWatch, procStopWatch;
+  DelphesFactory *factory = 0;
+  TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
+  DelphesHepMC2Reader *reader = 0;
+  DelphesInstance *instance;
+  vector<DelphesInstance *> instances;
+  vector<DelphesInstance *>::iterator itInstances;
+  TRandom *random = gRandom;
+  Int_t i, first, maxEvents, skipEvents;
+  Long64_t length, eventCounter;
+
+  // configuration and output files come in pairs before the optional --
+  for(first = 1; first < argc && strncmp(argv[first], "--", 3) != 0; ++first) continue;
+
+  if(first < 3 || (first - 1) % 2 != 0)
+  {
+    cout << " Usage: " << appName << " config_file output_file"
+         << " [config_file output_file ...]"
+         << " [-- input_file(s)]" << endl;
+    cout << " config_file - configuration file in Tcl format," << endl;
+    cout << " output_file - output file in ROOT format," << endl;
+    cout << " input_file(s) - input file(s) in HepMC format," << endl;
+    cout << " with no input_file, or when input_file is -, read standard input." << endl;
+    cout << " Each event is read once and simulated with every configuration file." << endl;
+    return 1;
+  }
+
+  signal(SIGINT, SignalHandler);
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    for(i = 1; i < first; i += 2)
+    {
+      instance = new DelphesInstance();
+      instances.push_back(instance);
+
+      instance->outputFile = TFile::Open(argv[i + 1], "CREATE");
+
+      if(instance->outputFile == NULL)
+      {
+        message << "can't create output file " << argv[i + 1];
+        throw runtime_error(message.str());
+      }
+
+      instance->treeWriter = new ExRootTreeWriter(instance->outputFile, "Delphes");
+
+      instance->branchEvent = instance->treeWriter->NewBranch("Event", HepMCEvent::Class());
+      instance->branchWeight = instance->treeWriter->NewBranch("Weight", Weight::Class());
+
+      instance->confReader = new ExRootConfReader;
+      instance->confReader->ReadFile(argv[i]);
+
+      // Delphes::Init seeds the random number generator of this instance
+      instance->random = new TRandom3;
+      gRandom = instance->random;
+
+      instance->modularDelphes = new Delphes("Delphes");
+      instance->modularDelphes->SetConfReader(instance->confReader);
+      instance->modularDelphes->SetTreeWriter(instance->treeWriter);
+
+      instance->factory = instance->modularDelphes->GetFactory();
+      instance->allParticleOutputArray = instance->modularDelphes->ExportArray("allParticles");
+      instance->stableParticleOutputArray = instance->modularDelphes->ExportArray("stableParticles");
+      instance->partonOutputArray = instance->modularDelphes->ExportArray("partons");
+
+      instance->modularDelphes->InitTask();
+    }
+
+    // the event range is taken from the first configuration file
+    maxEvents = instances.front()->confReader->GetInt("::MaxEvents", 0);
+    skipEvents = instances.front()->confReader->GetInt("::SkipEvents", 0);
+
+    if(maxEvents < 0)
+    {
+      throw runtime_error("MaxEvents must be zero or positive");
+    }
+
+    if(skipEvents < 0)
+    {
+      throw runtime_error("SkipEvents must be zero or positive");
+    }
+
+    // the input particles are read once into a separate factory
+    factory = new DelphesFactory("InputFactory");
+    allParticleOutputArray = factory->NewPermanentArray();
+    stableParticleOutputArray = factory->NewPermanentArray();
+    partonOutputArray = factory->NewPermanentArray();
+
+    reader = new DelphesHepMC2Reader;
+
+    i = first + 1;
+    do
+    {
+      if(interrupted) break;
+
+      if(i >= argc || strncmp(argv[i], "-", 2) == 0)
+      {
+        cout << "** Reading standard input" << endl;
+        inputFile = stdin;
+        length = -1;
+      }
+      else
+      {
+        cout << "** Reading " << argv[i] << endl;
+        inputFile = fopen(argv[i], "r");
+
+        if(inputFile == NULL)
+        {
+          message << "can't open " << argv[i];
+          throw runtime_error(message.str());
+        }
+
+        fseek(inputFile, 0L, SEEK_END);
+        length = ftello(inputFile);
+        fseek(inputFile, 0L, SEEK_SET);
+
+        if(length <= 0)
+        {
+          fclose(inputFile);
+          ++i;
+          continue;
+        }
+      }
+
+      reader->SetInputFile(inputFile);
+
+      ExRootProgressBar progressBar(length);
+
+      // Loop over all objects
+      eventCounter = 0;
+      for(itInstances = instances.begin(); itInstances != instances.end(); ++itInstances)
+      {
+        (*itInstances)->treeWriter->Clear();
+        (*itInstances)->modularDelphes->Clear();
+      }
+      factory->Clear();
+      reader->Clear();
+      readStopWatch.Start();
+      while((maxEvents <= 0 || eventCounter - skipEvents < maxEvents) && reader->ReadBlock(factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray) && !interrupted)
+      {
+        if(reader->EventReady())
+        {
+          ++eventCounter;
+
+          readStopWatch.Stop();
+
+          if(eventCounter > skipEvents)
+          {
+            for(itInstances = instances.begin(); itInstances != instances.end(); ++itInstances)
+            {
+              instance = *itInstances;
+
+              // clearing the factory restarts the unique IDs of the candidates,
+              // so that each instance numbers its objects as in a separate run
+              instance->modularDelphes->Clear();
+
+              CopyParticles(allParticleOutputArray, stableParticleOutputArray, partonOutputArray, instance);
+
+              gRandom = instance->random;
+
+              procStopWatch.Start();
+              instance->modularDelphes->ProcessTask();
+              procStopWatch.Stop();
+
+              reader->AnalyzeEvent(instance->branchEvent, eventCounter, &readStopWatch, &procStopWatch);
+              reader->AnalyzeWeight(instance->branchWeight);
+
+              if(!instance->modularDelphes->IsEventRejected()) instance->treeWriter->Fill();
+
+              instance->treeWriter->Clear();
+            }
+          }
+
+          factory->Clear();
+          reader->Clear();
+
+          readStopWatch.Start();
+        }
+        progressBar.Update(ftello(inputFile), eventCounter);
+      }
+
+      fseek(inputFile, 0L, SEEK_END);
+      progressBar.Update(ftello(inputFile), eventCounter, kTRUE);
+      progressBar.Finish();
+
+      if(inputFile != stdin) fclose(inputFile);
+
+      ++i;
+    } while(i < argc);
+
+    for(itInstances = instances.begin(); itInstances != instances.end(); ++itInstances)
+    {
+      instance = *itInstances;
+
+      gRandom = instance->random;
+      instance->outputFile->cd();
+
+      instance->modularDelphes->FinishTask();
+      instance->treeWriter->Write();
+    }
+
+    gRandom = random;
+
+    cout << "** Exiting..." << endl;
+
+    delete reader;
+    delete factory;
+
+    for(itInstances = instances.begin(); itInstances != instances.end(); ++itInstances)
+    {
+      instance = *itInstances;
+      delete instance->modularDelphes;
+      delete instance->confReader;
+      delete instance->treeWriter;
+      delete instance->outputFile;
+      delete instance->random;
+      delete instance;
+    }
+
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    gRandom = random;
+    for(itInstances = instances.begin(); itInstances != instances.end(); ++itInstances)
+    {
+      instance = *itInstances;
+      if(instance->treeWriter) delete instance->treeWriter;
+      if(instance->outputFile) delete instance->outputFile;
+    }
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
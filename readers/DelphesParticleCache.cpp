@@ -0,0 +1,207 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <signal.h>
+
+#include "TApplication.h"
+#include "TROOT.h"
+
+#include "TFile.h"
+#include "TObjArray.h"
+#include "TStopwatch.h"
+
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+#include "classes/DelphesParticleCacheReader.h"
+#include "modules/Delphes.h"
+
+#include "ExRootAnalysis/ExRootProgressBar.h"
+#include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeWriter.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+static bool interrupted = false;
+
+void SignalHandler(int sig)
+{
+  interrupted = true;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "DelphesParticleCache";
+  stringstream message;
+  TFile *outputFile = 0;
+  TStopwatch readStopWatch, procStopWatch;
+  ExRootTreeWriter *treeWriter = 0;
+  ExRootTreeBranch *branchEvent = 0, *branchWeight = 0;
+  ExRootConfReader *confReader = 0;
+  Delphes *modularDelphes = 0;
+  DelphesFactory *factory = 0;
+  TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
+  DelphesParticleCacheReader *reader = 0;
+  Int_t i, maxEvents, skipEvents;
+  Long64_t entry, entries, firstEntry, lastEntry, eventCounter;
+
+  if(argc < 4)
+  {
+    cout << " Usage: " << appName << " config_file"
+         << " output_file"
+         << " input_file(s)" << endl;
+    cout << " config_file - configuration file in Tcl format," << endl;
+    cout << " output_file - output file in ROOT format," << endl;
+    cout << " input_file(s) - input file(s) written with the ParticleCacheFile option." << endl;
+    return 1;
+  }
+
+  signal(SIGINT, SignalHandler);
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    outputFile = TFile::Open(argv[2], "CREATE");
+
+    if(outputFile == NULL)
+    {
+      message << "can't create output file " << argv[2];
+      throw runtime_error(message.str());
+    }
+
+    treeWriter = new ExRootTreeWriter(outputFile, "Delphes");
+
+    branchEvent = treeWriter->NewBranch("Event", HepMCEvent::Class());
+    branchWeight = treeWriter->NewBranch("Weight", Weight::Class());
+
+    confReader = new ExRootConfReader;
+    confReader->ReadFile(argv[1]);
+
+    maxEvents = confReader->GetInt("::MaxEvents", 0);
+    skipEvents = confReader->GetInt("::SkipEvents", 0);
+
+    if(maxEvents < 0)
+    {
+      throw runtime_error("MaxEvents must be zero or positive");
+    }
+
+    if(skipEvents < 0)
+    {
+      throw runtime_error("SkipEvents must be zero or positive");
+    }
+
+    modularDelphes = new Delphes("Delphes");
+    modularDelphes->SetConfReader(confReader);
+    modularDelphes->SetTreeWriter(treeWriter);
+
+    factory = modularDelphes->GetFactory();
+    allParticleOutputArray = modularDelphes->ExportArray("allParticles");
+    stableParticleOutputArray = modularDelphes->ExportArray("stableParticles");
+    partonOutputArray = modularDelphes->ExportArray("partons");
+
+    modularDelphes->InitTask();
+
+    // the event range refers to the events of all input files taken together
+    eventCounter = 0;
+    for(i = 3; i < argc && !interrupted; ++i)
+    {
+      if(maxEvents > 0 && eventCounter - skipEvents >= maxEvents) break;
+
+      cout << "** Reading " << argv[i] << endl;
+
+      reader = new DelphesParticleCacheReader(argv[i]);
+
+      entries = reader->GetEntries();
+
+      // use the event index to jump directly to the requested events
+      firstEntry = TMath::Min(TMath::Max(skipEvents - eventCounter, Long64_t(0)), entries);
+      lastEntry = entries;
+      if(maxEvents > 0) lastEntry = TMath::Min(TMath::Max(skipEvents + maxEvents - eventCounter, firstEntry), entries);
+
+      ExRootProgressBar progressBar(lastEntry - firstEntry - 1);
+
+      // Loop over all objects
+      treeWriter->Clear();
+      modularDelphes->Clear();
+      readStopWatch.Start();
+      for(entry = firstEntry; entry < lastEntry && !interrupted; ++entry)
+      {
+        reader->ReadEntry(entry);
+        reader->ReadParticles(factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray);
+
+        readStopWatch.Stop();
+
+        procStopWatch.Start();
+        modularDelphes->ProcessTask();
+        procStopWatch.Stop();
+
+        reader->AnalyzeEvent(branchEvent, eventCounter + entry + 1, &readStopWatch, &procStopWatch);
+        reader->AnalyzeWeight(branchWeight);
+
+        if(!modularDelphes->IsEventRejected()) treeWriter->Fill();
+
+        treeWriter->Clear();
+        modularDelphes->Clear();
+
+        readStopWatch.Start();
+
+        progressBar.Update(entry - firstEntry, entry - firstEntry + 1);
+      }
+
+      progressBar.Update(lastEntry - firstEntry, lastEntry - firstEntry, kTRUE);
+      progressBar.Finish();
+
+      eventCounter += entries;
+
+      delete reader;
+      reader = 0;
+    }
+
+    modularDelphes->FinishTask();
+    treeWriter->Write();
+
+    cout << "** Exiting..." << endl;
+
+    delete modularDelphes;
+    delete confReader;
+    delete treeWriter;
+    delete outputFile;
+
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    if(reader) delete reader;
+    if(treeWriter) delete treeWriter;
+    if(outputFile) delete outputFile;
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
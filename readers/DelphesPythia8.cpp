@@ -16,10 +16,15 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <signal.h>
 
@@ -49,91 +54,154 @@ using namespace std;
 
 //---------------------------------------------------------------------------
 
-void ConvertInput(Long64_t eventCounter, Pythia8::Pythia *pythia,
+// copy of a generated event, filled by the thread owning the Pythia instance
+
+struct TGenParticle
+{
+  Int_t pid, status;
+  Int_t m1, m2, d1, d2;
+  Double_t px, py, pz, e, mass;
+  Double_t x, y, z, t;
+};
+
+struct TGenEvent
+{
+  Bool_t ok, endOfFile;
+
+  Int_t code, id1, id2;
+  Double_t weight, scale, alphaEM, alphaS;
+  Double_t x1, x2, scalePDF, pdf1, pdf2;
+
+  vector<Double_t> weights;
+  vector<TGenParticle> particles;
+};
+
+//---------------------------------------------------------------------------
+
+void FillGenEvent(Pythia8::Pythia *pythia, TGenEvent &event)
+{
+  int i;
+  TGenParticle entry;
+
+  event.code = pythia->info.code();
+  event.weight = pythia->info.weight();
+
+  event.scale = pythia->info.QRen();
+  event.alphaEM = pythia->info.alphaEM();
+  event.alphaS = pythia->info.alphaS();
+
+  event.id1 = pythia->info.id1();
+  event.id2 = pythia->info.id2();
+  event.x1 = pythia->info.x1();
+  event.x2 = pythia->info.x2();
+  event.scalePDF = pythia->info.QFac();
+  event.pdf1 = pythia->info.pdf1();
+  event.pdf2 = pythia->info.pdf2();
+
+  event.weights.clear();
+#if PYTHIA_VERSION_INTEGER > 8300
+  // Pythia8 Weights - see https://pythia.org/latest-manual/CrossSectionsAndWeights.html
+  for(i = 0; i < int(pythia->info.weightNameVector().size()); ++i)
+  {
+    event.weights.push_back(pythia->info.weightValueVector()[i]);
+  }
+#endif
+
+  event.particles.resize(pythia->event.size() > 0 ? pythia->event.size() - 1 : 0);
+  for(i = 1; i < pythia->event.size(); ++i)
+  {
+    Pythia8::Particle &particle = pythia->event[i];
+
+    entry.pid = particle.id();
+    entry.status = particle.statusHepMC();
+    entry.m1 = particle.mother1() - 1;
+    entry.m2 = particle.mother2() - 1;
+    entry.d1 = particle.daughter1() - 1;
+    entry.d2 = particle.daughter2() - 1;
+    entry.px = particle.px();
+    entry.py = particle.py();
+    entry.pz = particle.pz();
+    entry.e = particle.e();
+    entry.mass = particle.m();
+    entry.x = particle.xProd();
+    entry.y = particle.yProd();
+    entry.z = particle.zProd();
+    entry.t = particle.tProd();
+
+    event.particles[i - 1] = entry;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void ConvertInput(Long64_t eventCounter, const TGenEvent &event,
   ExRootTreeBranch *branch, DelphesFactory *factory,
   TObjArray *allParticleOutputArray, TObjArray *stableParticleOutputArray, TObjArray *partonOutputArray,
   TStopwatch *readStopWatch, TStopwatch *procStopWatch)
 {
-  int i;
-
   HepMCEvent *element;
   Candidate *candidate;
   TDatabasePDG *pdg;
   TParticlePDG *pdgParticle;
   Int_t pdgCode;
-
-  Int_t pid, status;
-  Double_t px, py, pz, e, mass;
-  Double_t x, y, z, t;
+  vector<TGenParticle>::const_iterator itParticle;
 
   // event information
   element = static_cast<HepMCEvent *>(branch->NewEntry());
 
   element->Number = eventCounter;
 
-  element->ProcessID = pythia->info.code();
+  element->ProcessID = event.code;
   element->MPI = 1;
-  element->Weight = pythia->info.weight();
+  element->Weight = event.weight;
 
-  element->Scale = pythia->info.QRen();
-  element->AlphaQED = pythia->info.alphaEM();
-  element->AlphaQCD = pythia->info.alphaS();
+  element->Scale = event.scale;
+  element->AlphaQED = event.alphaEM;
+  element->AlphaQCD = event.alphaS;
 
-  element->ID1 = pythia->info.id1();
-  element->ID2 = pythia->info.id2();
-  element->X1 = pythia->info.x1();
-  element->X2 = pythia->info.x2();
-  element->ScalePDF = pythia->info.QFac();
-  element->PDF1 = pythia->info.pdf1();
-  element->PDF2 = pythia->info.pdf2();
+  element->ID1 = event.id1;
+  element->ID2 = event.id2;
+  element->X1 = event.x1;
+  element->X2 = event.x2;
+  element->ScalePDF = event.scalePDF;
+  element->PDF1 = event.pdf1;
+  element->PDF2 = event.pdf2;
 
   element->ReadTime = readStopWatch->RealTime();
   element->ProcTime = procStopWatch->RealTime();
 
   pdg = TDatabasePDG::Instance();
 
-  for(i = 1; i < pythia->event.size(); ++i)
+  for(itParticle = event.particles.begin(); itParticle != event.particles.end(); ++itParticle)
   {
-    Pythia8::Particle &particle = pythia->event[i];
-
-    pid = particle.id();
-    status = particle.statusHepMC();
-    px = particle.px();
-    py = particle.py();
-    pz = particle.pz();
-    e = particle.e();
-    mass = particle.m();
-    x = particle.xProd();
-    y = particle.yProd();
-    z = particle.zProd();
-    t = particle.tProd();
+    const TGenParticle &particle = *itParticle;
 
     candidate = factory->NewCandidate();
 
-    candidate->PID = pid;
+    candidate->PID = particle.pid;
     pdgCode = TMath::Abs(candidate->PID);
 
-    candidate->Status = status;
+    candidate->Status = particle.status;
 
-    candidate->M1 = particle.mother1() - 1;
-    candidate->M2 = particle.mother2() - 1;
+    candidate->M1 = particle.m1;
+    candidate->M2 = particle.m2;
 
-    candidate->D1 = particle.daughter1() - 1;
-    candidate->D2 = particle.daughter2() - 1;
+    candidate->D1 = particle.d1;
+    candidate->D2 = particle.d2;
 
-    pdgParticle = pdg->GetParticle(pid);
+    pdgParticle = pdg->GetParticle(particle.pid);
     candidate->Charge = pdgParticle ? Int_t(pdgParticle->Charge() / 3.0) : -999;
-    candidate->Mass = mass;
+    candidate->Mass = particle.mass;
 
-    candidate->Momentum.SetPxPyPzE(px, py, pz, e);
+    candidate->Momentum.SetPxPyPzE(particle.px, particle.py, particle.pz, particle.e);
 
-    candidate->Position.SetXYZT(x, y, z, t);
+    candidate->Position.SetXYZT(particle.x, particle.y, particle.z, particle.t);
 
     allParticleOutputArray->Add(candidate);
 
     if(!pdgParticle) continue;
 
-    if(status == 1)
+    if(particle.status == 1)
     {
       stableParticleOutputArray->Add(candidate);
     }
@@ -144,7 +212,6 @@ void ConvertInput(Long64_t eventCounter, Pythia8::Pythia *pythia,
   }
 }
 
-
 //---------------------------------------------------------------------------
 
 static bool interrupted = false;
@@ -220,6 +287,211 @@ void fillPartons(int id, double pMax, double etaMax,
 
 //---------------------------------------------------------------------------
 
+Pythia8::Pythia *NewPythia(const char *fileName)
+{
+  stringstream message;
+  Pythia8::Pythia *pythia;
+
+  pythia = new Pythia8::Pythia;
+
+  if(pythia == NULL)
+  {
+    throw runtime_error("can't create Pythia instance");
+  }
+
+  // jet matching
+#if PYTHIA_VERSION_INTEGER < 8300
+  Pythia8::CombineMatchingInput *combined = 0;
+  Pythia8::UserHooks *matching = 0;
+
+  matching = combined->getHook(*pythia);
+  if(!matching)
+  {
+    throw runtime_error("can't do matching");
+  }
+  pythia->setUserHooksPtr(matching);
+#else
+  Pythia8::CombineMatchingInput combined;
+  combined.setHook(*pythia);
+#endif
+
+  // Read in commands from configuration file
+  if(!pythia->readFile(fileName))
+  {
+    message << "can't read Pythia8 configuration file " << fileName << endl;
+    throw runtime_error(message.str());
+  }
+
+  return pythia;
+}
+
+//---------------------------------------------------------------------------
+
+struct TGunSettings
+{
+  Bool_t spareFlag1;
+  Int_t spareMode1;
+  Double_t spareParm1, spareParm2;
+};
+
+void GenerateEvent(Pythia8::Pythia *pythia, const TGunSettings &gun, TGenEvent &event)
+{
+  if(gun.spareFlag1)
+  {
+    if((gun.spareMode1 >= 1 && gun.spareMode1 <= 5) || gun.spareMode1 == 21)
+    {
+      fillPartons(gun.spareMode1, gun.spareParm1, gun.spareParm2, pythia->event, pythia->particleData, pythia->rndm);
+    }
+    else
+    {
+      fillParticle(gun.spareMode1, gun.spareParm1, gun.spareParm2, pythia->event, pythia->particleData, pythia->rndm);
+    }
+  }
+
+  event.ok = pythia->next();
+  event.endOfFile = !event.ok && pythia->info.atEndOfFile();
+
+  if(event.ok) FillGenEvent(pythia, event);
+}
+
+//---------------------------------------------------------------------------
+
+// independent Pythia8 instances on worker threads, generator i produces
+// events i, i + n, i + 2n, ... into its own ring, which keeps the order.
+// Only the random number generator is reseeded for each event, the internal
+// state of Pythia8 (e.g. maximum weight updates) evolves with the events of
+// each instance, so the output is reproducible for a given number of threads
+// but changes with it
+
+struct TGenPool
+{
+  vector<Pythia8::Pythia *> generators;
+  vector<thread> threads;
+
+  vector< vector<TGenEvent> > rings;
+  vector<size_t> heads, counts;
+
+  mutex ringMutex;
+  condition_variable notEmpty, notFull;
+  bool stop;
+
+  Long64_t numberOfEvents;
+  ULong64_t seed;
+  TGunSettings gun;
+
+  void Generate(size_t index);
+  void Next(Long64_t eventCounter, TGenEvent &event);
+  void Stop();
+  void Stat();
+};
+
+//---------------------------------------------------------------------------
+
+void TGenPool::Generate(size_t index)
+{
+  Pythia8::Pythia *pythia = generators[index];
+  vector<TGenEvent> &ring = rings[index];
+  TGenEvent event;
+  Long64_t slot;
+  ULong64_t z;
+
+  for(slot = index; slot < numberOfEvents; slot += generators.size())
+  {
+    // seed hashed from (seed, event number) with splitmix64,
+    // in the range 1..900000000 accepted by Pythia8
+    z = seed + 0x9E3779B97F4A7C15ULL * (slot + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    pythia->rndm.init(z % 900000000 + 1);
+
+    GenerateEvent(pythia, gun, event);
+
+    unique_lock<mutex> lock(ringMutex);
+    while(!stop && counts[index] == ring.size()) notFull.wait(lock);
+    if(stop) return;
+
+    swap(ring[(heads[index] + counts[index]) % ring.size()], event);
+    ++counts[index];
+    notEmpty.notify_one();
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void TGenPool::Next(Long64_t eventCounter, TGenEvent &event)
+{
+  size_t index = eventCounter % generators.size();
+
+  unique_lock<mutex> lock(ringMutex);
+  while(counts[index] == 0) notEmpty.wait(lock);
+
+  swap(event, rings[index][heads[index]]);
+  heads[index] = (heads[index] + 1) % rings[index].size();
+  --counts[index];
+  notFull.notify_all();
+}
+
+//---------------------------------------------------------------------------
+
+void TGenPool::Stop()
+{
+  vector<thread>::iterator itThreads;
+
+  {
+    lock_guard<mutex> lock(ringMutex);
+    stop = true;
+  }
+  notFull.notify_all();
+
+  for(itThreads = threads.begin(); itThreads != threads.end(); ++itThreads)
+  {
+    itThreads->join();
+  }
+  threads.clear();
+}
+
+//---------------------------------------------------------------------------
+
+void TGenPool::Stat()
+{
+  vector<Pythia8::Pythia *>::iterator itGenerators;
+  Pythia8::Pythia *pythia;
+  Double_t tried, accepted, weightSum, sigma, error;
+
+  tried = 0.0;
+  accepted = 0.0;
+  weightSum = 0.0;
+  sigma = 0.0;
+  error = 0.0;
+
+  for(itGenerators = generators.begin(); itGenerators != generators.end(); ++itGenerators)
+  {
+    pythia = *itGenerators;
+    pythia->stat();
+
+    // combine the cross section estimates weighted by the number of trials
+    tried += pythia->info.nTried();
+    accepted += pythia->info.nAccepted();
+    weightSum += pythia->info.weightSum();
+    sigma += pythia->info.nTried() * pythia->info.sigmaGen();
+    error += TMath::Power(pythia->info.nTried() * pythia->info.sigmaErr(), 2);
+  }
+
+  if(tried > 0.0)
+  {
+    sigma /= tried;
+    error = TMath::Sqrt(error) / tried;
+  }
+
+  cout << "** Merged statistics of " << generators.size() << " generators:" << endl;
+  cout << "** tried " << Long64_t(tried) << ", accepted " << Long64_t(accepted)
+       << ", sum of weights " << weightSum << endl;
+  cout << "** cross section " << sigma << " +- " << error << " mb" << endl;
+}
+
+//---------------------------------------------------------------------------
+
 int main(int argc, char *argv[])
 {
   char appName[] = "DelphesPythia8";
@@ -238,9 +510,12 @@ int main(int argc, char *argv[])
   DelphesLHEFReader *reader = 0;
   Long64_t eventCounter, errorCounter;
   Long64_t numberOfEvents, timesAllowErrors;
-  Bool_t spareFlag1;
-  Int_t spareMode1;
-  Double_t spareParm1, spareParm2;
+  TGunSettings gun;
+  TGenEvent event;
+  TGenPool *pool = 0;
+  Weight *weight;
+  vector<Double_t>::const_iterator itWeights;
+  Int_t i, numberOfThreads, bufferSize;
 
   Pythia8::Pythia *pythia = 0;
 
@@ -252,6 +527,7 @@ int main(int argc, char *argv[])
     cout << " config_file - configuration file in Tcl format," << endl;
     cout << " pythia_card - Pythia8 configuration file," << endl;
     cout << " output_file - output file in ROOT format." << endl;
+    cout << " set GeneratorThreads in config_file to generate on several threads." << endl;
     return 1;
   }
 
@@ -291,47 +567,35 @@ int main(int argc, char *argv[])
     partonOutputArray = modularDelphes->ExportArray("partons");
 
     // Initialize Pythia
-    pythia = new Pythia8::Pythia;
+    pythia = NewPythia(argv[2]);
 
-    if(pythia == NULL)
-    {
-      throw runtime_error("can't create Pythia instance");
-    }
+    // Extract settings to be used in the main program
+    numberOfEvents = pythia->mode("Main:numberOfEvents");
+    timesAllowErrors = pythia->mode("Main:timesAllowErrors");
 
-    // jet matching
-#if PYTHIA_VERSION_INTEGER < 8300
-    Pythia8::CombineMatchingInput *combined = 0;
-    Pythia8::UserHooks *matching = 0;
+    gun.spareFlag1 = pythia->flag("Main:spareFlag1");
+    gun.spareMode1 = pythia->mode("Main:spareMode1");
+    gun.spareParm1 = pythia->parm("Main:spareParm1");
+    gun.spareParm2 = pythia->parm("Main:spareParm2");
+
+    // generate with GeneratorThreads independent Pythia8 instances,
+    // each event reseeded from Random:seed and its event number,
+    // the output is reproducible for a given number of threads
+    numberOfThreads = confReader->GetInt("::GeneratorThreads", 0);
+    bufferSize = confReader->GetInt("::GeneratorBufferSize", 100);
 
-    matching = combined->getHook(*pythia);
-    if(!matching)
+    if(numberOfThreads < 0)
     {
-      throw runtime_error("can't do matching");
+      throw runtime_error("GeneratorThreads must be zero or positive");
     }
-    pythia->setUserHooksPtr(matching);
-#else
-    Pythia8::CombineMatchingInput combined;
-    combined.setHook(*pythia);
-#endif
 
-    // Read in commands from configuration file
-    if(!pythia->readFile(argv[2]))
+    if(bufferSize <= 0)
     {
-      message << "can't read Pythia8 configuration file " << argv[2] << endl;
-      throw runtime_error(message.str());
+      throw runtime_error("GeneratorBufferSize must be positive");
     }
 
-    // Extract settings to be used in the main program
-    numberOfEvents = pythia->mode("Main:numberOfEvents");
-    timesAllowErrors = pythia->mode("Main:timesAllowErrors");
-
-    spareFlag1 = pythia->flag("Main:spareFlag1");
-    spareMode1 = pythia->mode("Main:spareMode1");
-    spareParm1 = pythia->parm("Main:spareParm1");
-    spareParm2 = pythia->parm("Main:spareParm2");
-        
     // Check if particle gun
-    if(!spareFlag1)
+    if(!gun.spareFlag1)
     {
       inputFile = fopen(pythia->word("Beams:LHEF").c_str(), "r");
       if(inputFile)
@@ -350,7 +614,51 @@ int main(int argc, char *argv[])
 
     modularDelphes->InitTask();
 
-    pythia->init();
+    if(numberOfThreads > 0)
+    {
+      if(reader)
+      {
+        throw runtime_error("GeneratorThreads can't be used with LHEF input");
+      }
+
+      pool = new TGenPool;
+      pool->stop = false;
+      pool->numberOfEvents = numberOfEvents;
+
+      // Random:seed = 0 keeps its time-based meaning, the negative default
+      // seed of Pythia8 would give the same events in every job
+      if(!pythia->flag("Random:setSeed") || pythia->mode("Random:seed") < 0)
+      {
+        throw runtime_error("GeneratorThreads requires Random:setSeed = on and Random:seed = 0 (time-based) or positive");
+      }
+
+      pool->seed = pythia->mode("Random:seed");
+      if(pool->seed == 0)
+      {
+        random_device device;
+        pool->seed = (ULong64_t(device()) << 32) | device();
+      }
+      pool->gun = gun;
+
+      for(i = 0; i < numberOfThreads; ++i)
+      {
+        pool->generators.push_back(NewPythia(argv[2]));
+        pool->generators.back()->init();
+      }
+
+      pool->rings.resize(numberOfThreads, vector<TGenEvent>(bufferSize));
+      pool->heads.resize(numberOfThreads, 0);
+      pool->counts.resize(numberOfThreads, 0);
+
+      for(i = 0; i < numberOfThreads; ++i)
+      {
+        pool->threads.push_back(thread(&TGenPool::Generate, pool, i));
+      }
+    }
+    else
+    {
+      pythia->init();
+    }
 
     // ExRootProgressBar progressBar(numberOfEvents - 1);
     ExRootProgressBar progressBar(-1);
@@ -362,25 +670,22 @@ int main(int argc, char *argv[])
     readStopWatch.Start();
     for(eventCounter = 0; eventCounter < numberOfEvents && !interrupted; ++eventCounter)
     {
-      while(reader && reader->ReadBlock(factory, allParticleOutputArrayLHEF, stableParticleOutputArrayLHEF, partonOutputArrayLHEF) && !reader->EventReady())
-        ;
-
-      if(spareFlag1)
+      if(pool)
       {
-        if((spareMode1 >= 1 && spareMode1 <= 5) || spareMode1 == 21)
-        {
-          fillPartons(spareMode1, spareParm1, spareParm2, pythia->event, pythia->particleData, pythia->rndm);
-        }
-        else
-        {
-          fillParticle(spareMode1, spareParm1, spareParm2, pythia->event, pythia->particleData, pythia->rndm);
-        }
+        pool->Next(eventCounter, event);
+      }
+      else
+      {
+        while(reader && reader->ReadBlock(factory, allParticleOutputArrayLHEF, stableParticleOutputArrayLHEF, partonOutputArrayLHEF) && !reader->EventReady())
+          ;
+
+        GenerateEvent(pythia, gun, event);
       }
 
-      if(!pythia->next())
+      if(!event.ok)
       {
         // If failure because reached end of file then exit event loop
-        if(pythia->info.atEndOfFile())
+        if(event.endOfFile)
         {
           cerr << "Aborted since reached end of Les Houches Event File" << endl;
           break;
@@ -394,14 +699,14 @@ int main(int argc, char *argv[])
         }
 
         modularDelphes->Clear();
-        reader->Clear();
+        if(reader) reader->Clear();
         continue;
       }
 
       readStopWatch.Stop();
 
       procStopWatch.Start();
-      ConvertInput(eventCounter, pythia, branchEvent, factory,
+      ConvertInput(eventCounter, event, branchEvent, factory,
         allParticleOutputArray, stableParticleOutputArray, partonOutputArray,
         &readStopWatch, &procStopWatch);
       modularDelphes->ProcessTask();
@@ -413,17 +718,14 @@ int main(int argc, char *argv[])
         reader->AnalyzeWeight(branchWeightLHEF);
       }
 
-#if PYTHIA_VERSION_INTEGER > 8300
-      // fill Pythia8 Weights - see https://pythia.org/latest-manual/CrossSectionsAndWeights.html
-      for(int iWeight = 0; iWeight < pythia->info.weightNameVector().size(); ++iWeight)
+      // fill Pythia8 Weights
+      for(itWeights = event.weights.begin(); itWeights != event.weights.end(); ++itWeights)
       {
-        Weight *weight;
         weight = static_cast<Weight *>(branchWeight->NewEntry());
-        weight->Weight = pythia->info.weightValueVector()[iWeight];
+        weight->Weight = *itWeights;
       }
-#endif
-      
-      treeWriter->Fill();
+
+      if(!modularDelphes->IsEventRejected()) treeWriter->Fill();
 
       treeWriter->Clear();
       modularDelphes->Clear();
@@ -436,13 +738,27 @@ int main(int argc, char *argv[])
     progressBar.Update(eventCounter, eventCounter, kTRUE);
     progressBar.Finish();
 
-    pythia->stat();
+    if(pool)
+    {
+      pool->Stop();
+      pool->Stat();
+    }
+    else
+    {
+      pythia->stat();
+    }
 
     modularDelphes->FinishTask();
     treeWriter->Write();
 
     cout << "** Exiting..." << endl;
 
+    if(pool)
+    {
+      for(i = 0; i < Int_t(pool->generators.size()); ++i) delete pool->generators[i];
+      delete pool;
+    }
+
     delete reader;
     delete pythia;
     delete modularDelphes;
@@ -454,6 +770,7 @@ int main(int argc, char *argv[])
   }
   catch(runtime_error &e)
   {
+    if(pool) pool->Stop();
     if(treeWriter) delete treeWriter;
     if(outputFile) delete outputFile;
     cerr << "** ERROR: " << e.what() << endl;
@@ -34,6 +34,7 @@
 
 #include "TClonesArray.h"
 #include "TDatabasePDG.h"
+#include "TChain.h"
 #include "TFile.h"
 #include "TLorentzVector.h"
 #include "TObjArray.h"
@@ -54,6 +55,54 @@ using namespace std;
 
 //---------------------------------------------------------------------------
 
+// GenParticle data members used to build the Delphes candidates
+static const char *gParticleColumns[] = {
+  "PID", "Status", "M1", "M2", "D1", "D2", "Charge", "Mass",
+  "E", "Px", "Py", "Pz", "T", "X", "Y", "Z", 0};
+
+//---------------------------------------------------------------------------
+
+void ConfigureChain(TChain *chain, Bool_t selectiveRead, Long64_t cacheSize, Bool_t parallelUnzip, Long64_t firstEntry)
+{
+  Int_t i;
+
+  if(selectiveRead)
+  {
+    // disable all GenParticle data members and enable only the needed ones
+    chain->SetBranchStatus("Particle.*", kFALSE);
+    for(i = 0; gParticleColumns[i]; ++i)
+    {
+      chain->SetBranchStatus(Form("Particle.%s", gParticleColumns[i]), kTRUE);
+    }
+  }
+
+  if(parallelUnzip) chain->SetParallelUnzip(kTRUE);
+
+  if(cacheSize <= 0) return;
+
+  chain->SetCacheSize(cacheSize);
+
+  // fill the cache only with the baskets of the branches read below,
+  // starting from the first entry of the requested range
+  chain->LoadTree(firstEntry);
+
+  chain->AddBranchToCache("Event*", kTRUE);
+  if(selectiveRead)
+  {
+    chain->AddBranchToCache("Particle", kFALSE);
+    for(i = 0; gParticleColumns[i]; ++i)
+    {
+      chain->AddBranchToCache(Form("Particle.%s", gParticleColumns[i]), kFALSE);
+    }
+  }
+  else
+  {
+    chain->AddBranchToCache("Particle*", kTRUE);
+  }
+
+  chain->StopCacheLearningPhase();
+}
+
 //---------------------------------------------------------------------------
 
 static bool interrupted = false;
@@ -75,6 +124,9 @@ int main(int argc, char *argv[])
   ExRootTreeWriter *treeWriter = 0;
   ExRootTreeBranch *branchEvent = 0;
   ExRootConfReader *confReader = 0;
+  ExRootTreeReader *treeReader = 0;
+  TChain *chain = 0;
+  TClonesArray *branchParticle = 0, *branchHepMCEvent = 0;
   Delphes *modularDelphes = 0;
   DelphesFactory *factory = 0;
   GenParticle *gen;
@@ -86,7 +138,9 @@ int main(int argc, char *argv[])
 
   TObjArray *allParticleOutputArray = 0, *stableParticleOutputArray = 0, *partonOutputArray = 0;
   Int_t i;
-  Long64_t eventCounter, numberOfEvents;
+  Long64_t eventCounter, entry, allEntries, firstEntry, lastEntry;
+  Long64_t maxEvents, skipEvents, cacheSize;
+  Bool_t selectiveRead, parallelUnzip;
 
   if(argc < 4)
   {
@@ -124,12 +178,32 @@ int main(int argc, char *argv[])
     confReader = new ExRootConfReader;
     confReader->ReadFile(argv[1]);
 
+    maxEvents = confReader->GetInt("::MaxEvents", 0);
+    skipEvents = confReader->GetInt("::SkipEvents", 0);
+
+    if(maxEvents < 0)
+    {
+      throw runtime_error("MaxEvents must be zero or positive");
+    }
+
+    if(skipEvents < 0)
+    {
+      throw runtime_error("SkipEvents must be zero or positive");
+    }
+
+    // read only the GenParticle data members needed to build the candidates
+    selectiveRead = confReader->GetBool("::SelectiveRead", false);
+
+    // size of the TTreeCache in bytes, 0 keeps the ROOT default
+    cacheSize = confReader->GetLong("::TreeCacheSize", 0);
+
+    // decompress the cached baskets in parallel
+    parallelUnzip = confReader->GetBool("::ParallelUnzip", false);
+
     modularDelphes = new Delphes("Delphes");
     modularDelphes->SetConfReader(confReader);
     modularDelphes->SetTreeWriter(treeWriter);
 
-    TChain *chain = new TChain("Delphes");
-
     factory = modularDelphes->GetFactory();
     allParticleOutputArray = modularDelphes->ExportArray("allParticles");
     stableParticleOutputArray = modularDelphes->ExportArray("stableParticles");
@@ -137,13 +211,12 @@ int main(int argc, char *argv[])
 
     modularDelphes->InitTask();
 
+    chain = new TChain("Delphes");
+
     for(i = 3; i < argc && !interrupted; ++i)
     {
       cout << "** Reading " << argv[i] << endl;
 
-      chain->Add(argv[i]);
-      ExRootTreeReader *treeReader = new ExRootTreeReader(chain);
-
       inputFile = TFile::Open(argv[i]);
 
       if(inputFile == NULL)
@@ -152,30 +225,45 @@ int main(int argc, char *argv[])
         throw runtime_error(message.str());
       }
 
-      numberOfEvents = treeReader->GetEntries();
-      TClonesArray *branchParticle = treeReader->UseBranch("Particle");
-      TClonesArray *branchHepMCEvent = treeReader->UseBranch("Event");
+      inputFile->Close();
+      delete inputFile;
 
-      if(numberOfEvents <= 0) continue;
+      chain->Add(argv[i]);
+    }
+
+    treeReader = new ExRootTreeReader(chain);
+
+    allEntries = treeReader->GetEntries();
+
+    // the event range refers to the entries of all input files taken together
+    firstEntry = TMath::Min(skipEvents, allEntries);
+    lastEntry = allEntries;
+    if(maxEvents > 0) lastEntry = TMath::Min(firstEntry + maxEvents, allEntries);
+
+    if(lastEntry > firstEntry && !interrupted)
+    {
+      branchParticle = treeReader->UseBranch("Particle");
+      branchHepMCEvent = treeReader->UseBranch("Event");
+
+      ConfigureChain(chain, selectiveRead, cacheSize, parallelUnzip, firstEntry);
 
-      // ExRootProgressBar progressBar(numberOfEvents - 1);
-      ExRootProgressBar progressBar(-1);
+      ExRootProgressBar progressBar(lastEntry - firstEntry - 1);
 
       // Loop over all objects
       eventCounter = 0;
       modularDelphes->Clear();
       treeWriter->Clear();
-      for(Int_t entry = 0; entry < numberOfEvents && !interrupted; ++entry)
+      for(entry = firstEntry; entry < lastEntry && !interrupted; ++entry)
       {
-
-        treeReader->ReadEntry(entry);
+        if(!treeReader->ReadEntry(entry)) break;
 
         // -- TBC need also to include event weights --
 
         eve = (HepMCEvent *)branchHepMCEvent->At(0);
         element = static_cast<HepMCEvent *>(branchEvent->NewEntry());
 
-        element->Number = eventCounter;
+        // event number within the current input file, as before the files were chained
+        element->Number = entry - chain->GetTreeOffset()[chain->GetTreeNumber()];
 
         element->ProcessID = eve->ProcessID;
         element->MPI = eve->MPI;
@@ -232,7 +320,7 @@ int main(int argc, char *argv[])
 
         modularDelphes->ProcessTask();
 
-        treeWriter->Fill();
+        if(!modularDelphes->IsEventRejected()) treeWriter->Fill();
 
         modularDelphes->Clear();
         treeWriter->Clear();
@@ -243,10 +331,6 @@ int main(int argc, char *argv[])
 
       progressBar.Update(eventCounter, eventCounter, kTRUE);
       progressBar.Finish();
-
-      inputFile->Close();
-
-      delete treeReader;
     }
 
     modularDelphes->FinishTask();
@@ -254,6 +338,7 @@ int main(int argc, char *argv[])
 
     cout << "** Exiting..." << endl;
 
+    delete treeReader;
     delete modularDelphes;
     delete confReader;
     delete treeWriter;